@@ -46,7 +46,37 @@ enum candle_frame_type {
     CANDLE_FRAME_TYPE_ERR = 1 << 3,
     CANDLE_FRAME_TYPE_FD = 1 << 4,
     CANDLE_FRAME_TYPE_BRS = 1 << 5,
-    CANDLE_FRAME_TYPE_ESI = 1 << 6
+    CANDLE_FRAME_TYPE_ESI = 1 << 6,
+    CANDLE_FRAME_TYPE_OVERFLOW = 1 << 7     // rx only, device lost frames before this one
+};
+
+enum candle_rx_queue_type {
+    CANDLE_RX_QUEUE_SPSC = 0,   // lock-free, at most one reader thread per channel (default)
+    CANDLE_RX_QUEUE_LOCKED      // mutex protected, any number of reader threads
+};
+
+enum candle_rx_overflow_policy {
+    CANDLE_RX_OVERFLOW_DROP_NEWEST = 0,     // discard the incoming frame (default)
+    CANDLE_RX_OVERFLOW_DROP_OLDEST          // discard the oldest queued frame (uses the locked queue)
+};
+
+enum candle_rx_filter_flag {
+    CANDLE_RX_FILTER_EXTENDED = 1 << 0,     // match 29-bit ids, 11-bit ids otherwise
+    CANDLE_RX_FILTER_RANGE = 1 << 1,        // match id to last_id instead of id and mask
+    CANDLE_RX_FILTER_DATA_ONLY = 1 << 2,    // data and remote frames match unless one of these is set
+    CANDLE_RX_FILTER_REMOTE_ONLY = 1 << 3,
+    CANDLE_RX_FILTER_ERROR = 1 << 4         // accept error frames, the other fields are ignored
+};
+
+enum candle_event_thread_policy {
+    CANDLE_EVENT_THREAD_SHARED = 0,     // one thread serves all devices with this policy (default)
+    CANDLE_EVENT_THREAD_PER_DEVICE,     // the device gets a thread of its own
+    CANDLE_EVENT_THREAD_SHARDED         // devices with the same shard number share a thread
+};
+
+enum candle_event_mode {
+    CANDLE_EVENT_MODE_THREAD = 0,       // library threads handle the usb events (default)
+    CANDLE_EVENT_MODE_APPLICATION       // no library thread, the application calls candle_handle_events (blocking calls handle events while they wait)
 };
 
 enum candle_can_state {
@@ -64,6 +94,26 @@ struct candle_state {
     uint32_t txerr;
 };
 
+struct candle_event_thread_config {
+    enum candle_event_thread_policy policy;
+    uint32_t shard;     // CANDLE_EVENT_THREAD_SHARDED only
+    int cpu;            // pin the thread to this cpu (Linux, Windows), -1 for no affinity
+    int priority;       // SCHED_FIFO priority (time critical on Windows), 0 keeps the default scheduling
+    uint32_t busy_poll_us;  // poll without blocking this long after each wake-up before sleeping again, 0 always sleeps
+};
+
+struct candle_rx_filter {
+    uint32_t id;
+    uint32_t mask;      // a frame matches if (can_id & mask) == (id & mask)
+    uint32_t last_id;   // CANDLE_RX_FILTER_RANGE only
+    uint32_t flags;     // enum candle_rx_filter_flag
+};
+
+struct candle_pollfd {
+    int fd;
+    short events;       // POLLIN / POLLOUT
+};
+
 struct candle_bit_timing_const {
     uint32_t tseg1_min;
     uint32_t tseg1_max;
@@ -88,7 +138,54 @@ struct candle_can_frame {
     uint32_t can_id;
     uint8_t can_dlc;
     uint8_t data[64];
-    uint32_t timestamp_us;
+    uint64_t timestamp_us;          // hardware timestamp unwrapped to 64 bit, 0 without CANDLE_MODE_HW_TIMESTAMP
+    uint64_t timestamp_host_ns;     // hardware timestamp mapped to host monotonic time, 0 without CANDLE_MODE_HW_TIMESTAMP
+    uint64_t receive_host_ns;       // host monotonic time the usb transfer completed (rx only)
+    uint64_t tag;                   // set by the caller before sending, carried by the echo and the tx completion
+};
+
+struct candle_tx_completion {
+    uint64_t tag;                   // tag of the sent frame
+    uint64_t timestamp_us;          // hardware timestamp of the echo, 0 without CANDLE_MODE_HW_TIMESTAMP
+    uint64_t timestamp_host_ns;     // hardware timestamp mapped to host monotonic time, 0 without CANDLE_MODE_HW_TIMESTAMP
+    uint64_t scheduled_host_ns;     // requested submit time (candle_send_frame_at, cyclic frames), 0 if sent right away
+    uint64_t submit_host_ns;        // host monotonic time the frame was submitted
+    uint64_t submit_lateness_ns;    // submit_host_ns - scheduled_host_ns, 0 if sent right away
+    uint64_t echo_host_ns;          // host monotonic time the echo was received
+    uint64_t latency_ns;            // echo_host_ns - submit_host_ns
+};
+
+#define CANDLE_TX_PRIORITY_CLASSES 8   // class n holds 11 bit base ids n * 256 to n * 256 + 255
+
+struct candle_tx_queue_stats {
+    uint64_t frames[CANDLE_TX_PRIORITY_CLASSES];        // frames moved from the queue to the device
+    uint64_t delay_sum_ns[CANDLE_TX_PRIORITY_CLASSES];  // total time those frames spent queued
+    uint64_t delay_max_ns[CANDLE_TX_PRIORITY_CLASSES];  // longest time a frame spent queued
+    uint64_t queue_full;                                // sends that found the queue full
+    uint64_t send_errors;                               // queued frames that could not be submitted
+    uint64_t queued;                                    // frames waiting at the time of the call
+};
+
+struct candle_cyclic_stats {
+    uint64_t sent;              // cycles whose frame was submitted
+    uint64_t send_errors;       // cycles whose frame could not be submitted (tx window full, channel stopped)
+    uint64_t missed;            // cycles skipped because the scheduler was more than a period late
+    uint64_t jitter_min_ns;     // submit time minus deadline, over sent and failed cycles
+    uint64_t jitter_max_ns;
+    uint64_t jitter_sum_ns;     // divide by sent + send_errors for the mean
+};
+
+struct candle_channel_stats {
+    uint64_t tx_pool_exhausted;     // sends that found no pre-built transfer and allocated one
+    uint64_t rx_dropped;            // frames lost because the rx queue was full
+    uint64_t rx_frames;             // frames (including echoes) received from the device
+    uint64_t device_overflows;      // frames the device flagged with an overflow
+    uint64_t tx_usb_errors;         // failed out transfers
+    uint64_t tx_usb_resubmits;      // out transfers submitted again after a failure or timeout
+    uint64_t rx_usb_errors;         // failed in transfers, shared by all channels of the device
+    uint64_t rx_usb_resubmits;      // in transfers submitted again after a failure or timeout, shared by all channels
+    uint64_t rx_filter_accepted;    // frames that passed the rx filters
+    uint64_t rx_filter_rejected;    // frames the rx filters dropped before queueing
 };
 
 struct candle_channel {
@@ -115,16 +212,36 @@ struct candle_device {
     struct candle_channel channels[];       // read only (size == channel_count)
 };
 
+// called on the event thread for every received frame (including echoes), must not block or reconfigure its own channel
+typedef void (*candle_rx_callback)(struct candle_device *device, uint8_t channel, const struct candle_can_frame *frame, void *user);
+
+// called on the event thread when the echo of a sent frame arrives (the frame is on the bus), must not block
+typedef void (*candle_tx_callback)(struct candle_device *device, uint8_t channel, const struct candle_tx_completion *completion, void *user);
+
 bool candle_initialize(void);
+bool candle_initialize_ex(enum candle_event_mode mode);
+bool candle_handle_events(uint32_t timeout_us);     // application-driven mode only, completes transfers and runs callbacks in the calling thread, 0 does not block
+bool candle_get_pollfds(struct candle_pollfd *fds, size_t max_count, size_t *count);   // application-driven mode only, not on Windows, call candle_handle_events(0) when one is ready; the set changes as devices open and close
 void candle_finalize(void);
 bool candle_get_device_list(struct candle_device ***devices, size_t *size);
 void candle_free_device_list(struct candle_device **devices);
 struct candle_device *candle_ref_device(struct candle_device *device);
 void candle_unref_device(struct candle_device *device);
+bool candle_set_rx_transfer_count(struct candle_device *device, size_t count);
+bool candle_set_busy_poll(struct candle_device *device, uint32_t microseconds);    // receive and wait calls spin this long on the rx queues before sleeping, 0 (default) sleeps right away
+bool candle_set_event_thread(struct candle_device *device, const struct candle_event_thread_config *config);    // only while closed, a shared thread takes its settings from the device that starts it
 bool candle_open_device(struct candle_device *device);
-void candle_close_device(struct candle_device *device);
-bool candle_reset_channel(struct candle_device *device, uint8_t channel);
+void candle_close_device(struct candle_device *device);    // stops the channels like candle_reset_channel
+bool candle_reset_channel(struct candle_device *device, uint8_t channel);  // wakes blocked readers and waits for them to return before the rx queue is flushed, frames still peeked are dropped and must not be read any more
 bool candle_start_channel(struct candle_device *device, uint8_t channel, enum candle_mode mode);
+bool candle_set_rx_queue_type(struct candle_device *device, uint8_t channel, enum candle_rx_queue_type type);
+bool candle_set_rx_queue_depth(struct candle_device *device, uint8_t channel, size_t depth);   // like the type and overflow policy only while stopped, waits for the event thread to leave the old queue
+bool candle_set_rx_overflow_policy(struct candle_device *device, uint8_t channel, enum candle_rx_overflow_policy policy);
+bool candle_set_rx_callback(struct candle_device *device, uint8_t channel, candle_rx_callback callback, void *user);   // NULL restores the rx queue
+bool candle_set_rx_filters(struct candle_device *device, uint8_t channel, const struct candle_rx_filter *filters, size_t count);  // only while stopped, frames matching none are dropped before queueing (echoes included), count 0 accepts everything
+bool candle_set_tx_callback(struct candle_device *device, uint8_t channel, candle_tx_callback callback, void *user);
+bool candle_set_tx_queue_depth(struct candle_device *device, uint8_t channel, size_t depth);    // queue sends by CAN id priority, 0 (default) sends directly
+bool candle_get_tx_queue_stats(struct candle_device *device, uint8_t channel, struct candle_tx_queue_stats *stats);
 bool candle_set_bit_timing(struct candle_device *device, uint8_t channel, struct candle_bit_timing *bit_timing);
 bool candle_set_data_bit_timing(struct candle_device *device, uint8_t channel, struct candle_bit_timing *bit_timing);
 bool candle_get_termination(struct candle_device *device, uint8_t channel, bool *enable);
@@ -132,9 +249,30 @@ bool candle_set_termination(struct candle_device *device, uint8_t channel, bool
 bool candle_get_state(struct candle_device *device, uint8_t channel, struct candle_state *state);
 bool candle_send_frame_nowait(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame);
 bool candle_send_frame(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint32_t milliseconds);
+bool candle_send_frame_us(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint64_t microseconds);  // the _us variants time out on the monotonic clock like the millisecond ones
+bool candle_send_frames(struct candle_device *device, uint8_t channel, struct candle_can_frame *frames, size_t count, uint32_t milliseconds, size_t *sent);
+bool candle_send_frames_us(struct candle_device *device, uint8_t channel, struct candle_can_frame *frames, size_t count, uint64_t microseconds, size_t *sent);
+bool candle_get_channel_stats(struct candle_device *device, uint8_t channel, struct candle_channel_stats *stats);
 bool candle_receive_frame_nowait(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame);
 bool candle_receive_frame(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint32_t milliseconds);
+bool candle_receive_frame_us(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint64_t microseconds);
+bool candle_receive_frames(struct candle_device *device, uint8_t channel, struct candle_can_frame *frames, size_t max_count, uint32_t milliseconds, size_t *count);
+bool candle_receive_frames_us(struct candle_device *device, uint8_t channel, struct candle_can_frame *frames, size_t max_count, uint64_t microseconds, size_t *count);
+bool candle_peek_frames(struct candle_device *device, uint8_t channel, const struct candle_can_frame **frames, size_t *count);    // lock-free rx queue only
+bool candle_commit_frames(struct candle_device *device, uint8_t channel, size_t count);  // release the first count peeked frames
 bool candle_wait_for_frame(struct candle_device *device, uint32_t milliseconds);
+bool candle_wait_for_frame_us(struct candle_device *device, uint64_t microseconds);
+bool candle_wait_for_channels(struct candle_device *device, uint32_t milliseconds, uint32_t *ready, size_t *depths);    // bit n of ready is set if channel n has frames, depths (optional) holds channel_count queue depths
+bool candle_wait_for_channels_us(struct candle_device *device, uint64_t microseconds, uint32_t *ready, size_t *depths);
+bool candle_send_frame_at(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint64_t monotonic_ns);   // queued until monotonic_ns (candle_monotonic_ns clock), then submitted like candle_send_frame_nowait
+bool candle_set_tx_schedule_spin(struct candle_device *device, uint32_t microseconds);  // busy-wait the last microseconds before scheduled and cyclic frames, 0 (default) only sleeps
+uint64_t candle_monotonic_ns(void);     // CLOCK_MONOTONIC, QueryPerformanceCounter on Windows
+bool candle_add_cyclic_frame(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint32_t period_us, uint32_t *id);   // first frame goes out right away, ids are valid until the device is closed
+bool candle_update_cyclic_frame(struct candle_device *device, uint32_t id, struct candle_can_frame *frame, uint32_t period_us);  // takes effect at the next cycle
+bool candle_remove_cyclic_frame(struct candle_device *device, uint32_t id);
+bool candle_get_cyclic_stats(struct candle_device *device, uint32_t id, struct candle_cyclic_stats *stats);
+bool candle_get_event_fd(struct candle_device *device, int *fd);      // readable once a frame is queued after the last reset (right away if frames are queued on the first call), not on Windows
+void candle_reset_event_fd(struct candle_device *device);             // call before draining the channels
 
 #ifdef __cplusplus
 }
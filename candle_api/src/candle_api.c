@@ -3,28 +3,103 @@
 #include "libusb.h"
 #include "list.h"
 #include "fifo.h"
+#include "spsc.h"
+#include "wakeup.h"
+#include "event_fd.h"
+#include "clock.h"
+#include "id_pool.h"
+#include "prio_queue.h"
+#include "cyclic.h"
+#include "event_group.h"
+#include "rx_filter.h"
 #include "gs_usb_def.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdatomic.h>
+#include <limits.h>
+
+#define RX_TRANSFER_COUNT_DEFAULT 8
+#define RX_TRANSFER_COUNT_MAX 32
+#define TX_SLOT_COUNT 32
+#define RX_QUEUE_DEPTH_DEFAULT 1024
+#define TX_PRIORITY_CLASS_SHIFT 29  // priority class from the top 3 bits of the base id
+
+// event_fd_state, the first candle_get_event_fd moves it from closed to open
+enum {
+    EVENT_FD_CLOSED = 0,
+    EVENT_FD_OPENING,
+    EVENT_FD_OPEN
+};
 
 static const uint8_t dlc2len[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
 static struct libusb_context *ctx = NULL;
+static bool app_driven = false;     // no event thread, the application calls candle_handle_events
 static LIST_HEAD(device_list);
-static size_t open_device_count;
-static thrd_t event_thread;
-static bool event_thread_run;
+
+struct candle_tx_slot {
+    struct candle_device_handle *handle;
+    struct libusb_transfer *transfer;
+    uint8_t channel;
+    int index;  // -1 if allocated on demand (pool exhausted)
+};
+
+struct rx_meta {
+    uint64_t hardware_us;
+    uint64_t hardware_host_ns;
+    uint64_t receive_host_ns;
+    uint64_t tag;   // echo only
+};
+
+struct tx_pending {
+    uint64_t tag;
+    uint64_t scheduled_host_ns;
+    uint64_t submit_host_ns;
+};
+
+struct tx_queue_entry {
+    uint64_t enqueue_host_ns;
+    uint64_t scheduled_host_ns;
+    struct candle_can_frame frame;
+};
 
 struct candle_channel_handle {
-    bool is_start;
+    atomic_bool is_start;
+    atomic_uint rx_readers;     // consumer calls in progress, reset and close wait for them to leave
+    atomic_uint in_callback;    // event thread callbacks using the channel, setters wait for them before freeing
+    size_t rx_peeked;           // frames handed out by candle_peek_frames and not committed yet
     enum candle_mode mode;
-    fifo_t *rx_fifo;
-    cnd_t rx_cnd;
-    mtx_t rx_cond_mtx;
-    atomic_uint_fast32_t echo_id_pool;
-    cnd_t echo_id_cnd;
-    mtx_t echo_id_cond_mtx;
+    enum candle_rx_queue_type rx_queue_type;
+    enum candle_rx_overflow_policy rx_overflow_policy;
+    size_t rx_queue_depth;
+    fifo_t *rx_fifo;    // locked queue (multiple readers or overflow policy other than drop newest)
+    spsc_t *rx_ring;    // lock-free queue
+    candle_rx_callback rx_callback;     // replaces the rx queue when set
+    void *rx_callback_user;
+    _Atomic(rx_filter_t *) rx_filter;   // NULL accepts every frame
+    clock_unwrap_t timestamp;   // event thread only
+    atomic_uint_fast64_t rx_dropped;
+    atomic_uint_fast64_t rx_frames;
+    atomic_uint_fast64_t device_overflows;
+    atomic_uint_fast64_t rx_filter_accepted;
+    atomic_uint_fast64_t rx_filter_rejected;
+    wakeup_t rx_wakeup;
+    id_pool_t echo_id_pool;
+    wakeup_t echo_id_wakeup;
+    struct tx_pending tx_pending[32];   // indexed by echo id, owned by the sender until the echo arrives
+    candle_tx_callback tx_callback;
+    void *tx_callback_user;
+    prio_queue_t *tx_queue;     // host side queue in arbitration order (NULL if disabled)
+    size_t tx_queue_depth;
+    mtx_t tx_queue_mtx;
+    wakeup_t tx_queue_wakeup;   // signalled when queued frames move into the echo id window
+    struct candle_tx_queue_stats tx_queue_stats;   // protected by tx_queue_mtx
+    struct candle_tx_slot tx_slots[TX_SLOT_COUNT];
+    uint8_t *tx_buffers;
+    id_pool_t tx_slot_pool;
+    atomic_uint_fast64_t tx_pool_exhausted;
+    atomic_uint_fast64_t tx_usb_errors;
+    atomic_uint_fast64_t tx_usb_resubmits;
 };
 
 struct candle_device_handle {
@@ -32,119 +107,564 @@ struct candle_device_handle {
     struct candle_device *device;
     struct libusb_device *usb_device;
     struct libusb_device_handle *usb_device_handle;
-    struct libusb_transfer *rx_transfer;
+    struct libusb_transfer *rx_transfers[RX_TRANSFER_COUNT_MAX];
+    size_t rx_transfer_count;
+    atomic_uint_fast64_t rx_usb_errors;
+    atomic_uint_fast64_t rx_usb_resubmits;
     size_t ref_count;
     size_t rx_size;
+    size_t tx_size;
     uint8_t in_ep;
     uint8_t out_ep;
-    cnd_t rx_cnd;
-    mtx_t rx_cond_mtx;
+    wakeup_t rx_wakeup;
+    atomic_uint_fast64_t busy_poll_ns;  // receivers spin this long before sleeping on rx_wakeup
+    event_fd_t event_fd;
+    atomic_int event_fd_state;
+    clock_sync_t clock_sync;    // event thread only
+    _Atomic(cyclic_t *) cyclic; // periodic tx scheduler, created on first use
+    struct candle_event_thread_config event_thread;
+    event_group_t *event_group; // context and thread serving the device while open
     struct candle_channel_handle channels[];
 };
 
-static int event_thread_func(void *arg) {
-    while (event_thread_run) {
-        libusb_handle_events(arg);
+// counters only written by the event thread, a plain load and store avoids a locked add
+static inline void stat_inc(atomic_uint_fast64_t *counter) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+// event thread side: a callback touches the queues and the filter of a started channel only between
+// channel_callback_enter and channel_callback_leave
+static bool channel_callback_enter(struct candle_channel_handle *ch) {
+    atomic_fetch_add(&ch->in_callback, 1);
+    if (atomic_load(&ch->is_start))
+        return true;
+    atomic_fetch_sub(&ch->in_callback, 1);
+    return false;
+}
+
+static void channel_callback_leave(struct candle_channel_handle *ch) {
+    atomic_fetch_sub(&ch->in_callback, 1);
+}
+
+// wait for the callbacks that still saw the channel started, after that a stopped channel's
+// queues and filter can be freed
+static void channel_quiesce(struct candle_channel_handle *ch) {
+    while (atomic_load(&ch->in_callback) != 0)
+        thrd_yield();
+}
+
+static void destroy_rx_queue(struct candle_channel_handle *ch) {
+    if (ch->rx_fifo != NULL)
+        fifo_destroy(ch->rx_fifo);
+    spsc_destroy(ch->rx_ring);
+    ch->rx_fifo = NULL;
+    ch->rx_ring = NULL;
+}
+
+// the locked queue stores its unit size in a char
+_Static_assert(sizeof(struct candle_can_frame) <= CHAR_MAX, "candle_can_frame does not fit in a fifo_t unit");
+
+static bool create_rx_queue(struct candle_channel_handle *ch, size_t unit_size, enum candle_rx_queue_type type, enum candle_rx_overflow_policy policy, size_t depth) {
+    fifo_t *rx_fifo = NULL;
+    spsc_t *rx_ring = NULL;
+
+    if (depth == 0 || depth > INT32_MAX || unit_size > CHAR_MAX)
+        return false;
+
+    // only the locked queue lets the producer touch queued frames
+    if (type == CANDLE_RX_QUEUE_SPSC && policy == CANDLE_RX_OVERFLOW_DROP_NEWEST) {
+        rx_ring = spsc_create(unit_size, depth);
+        if (rx_ring == NULL)
+            return false;
+    } else {
+        rx_fifo = fifo_create((char)unit_size, (int)depth);
+        if (rx_fifo == NULL)
+            return false;
+    }
+
+    // replace old queue once the event thread is done with it
+    channel_quiesce(ch);
+    destroy_rx_queue(ch);
+    ch->rx_queue_type = type;
+    ch->rx_overflow_policy = policy;
+    ch->rx_queue_depth = depth;
+    ch->rx_fifo = rx_fifo;
+    ch->rx_ring = rx_ring;
+    return true;
+}
+
+static void capture_timestamp(struct candle_device_handle *handle, struct candle_channel_handle *ch, struct gs_host_frame *hf, uint64_t host_ns, struct rx_meta *ts) {
+    ts->receive_host_ns = host_ns;
+    ts->tag = 0;
+    ts->hardware_us = 0;
+    ts->hardware_host_ns = 0;
+
+    if (!(ch->mode & CANDLE_MODE_HW_TIMESTAMP))
+        return;
+
+    uint32_t timestamp_us;
+    if (hf->flags & GS_CAN_FLAG_FD)
+        timestamp_us = hf->canfd_ts->timestamp_us;
+    else
+        timestamp_us = hf->classic_can_ts->timestamp_us;
+
+    // the 32 bit counter wraps every ~71.6 minutes, all channels share the device clock
+    ts->hardware_us = clock_unwrap(&ch->timestamp, timestamp_us, host_ns);
+    ts->hardware_host_ns = clock_sync_update(&handle->clock_sync, timestamp_us, host_ns);
+}
+
+static void convert_frame(struct gs_host_frame *hf, struct candle_can_frame *frame, const struct rx_meta *ts) {
+    frame->type = 0;
+    if (hf->echo_id == 0xFFFFFFFF)
+        frame->type |= CANDLE_FRAME_TYPE_RX;
+    if (hf->can_id & CAN_EFF_FLAG)
+        frame->type |= CANDLE_FRAME_TYPE_EFF;
+    if (hf->can_id & CAN_RTR_FLAG)
+        frame->type |= CANDLE_FRAME_TYPE_RTR;
+    if (hf->can_id & CAN_ERR_FLAG)
+        frame->type |= CANDLE_FRAME_TYPE_ERR;
+    if (hf->flags & GS_CAN_FLAG_FD)
+        frame->type |= CANDLE_FRAME_TYPE_FD;
+    if (hf->flags & GS_CAN_FLAG_BRS)
+        frame->type |= CANDLE_FRAME_TYPE_BRS;
+    if (hf->flags & GS_CAN_FLAG_ESI)
+        frame->type |= CANDLE_FRAME_TYPE_ESI;
+    if (hf->flags & GS_CAN_FLAG_OVERFLOW)
+        frame->type |= CANDLE_FRAME_TYPE_OVERFLOW;
+
+    if (hf->can_id & CAN_EFF_FLAG)
+        frame->can_id = hf->can_id & 0x1FFFFFFF;
+    else
+        frame->can_id = hf->can_id & 0x7FF;
+
+    frame->can_dlc = hf->can_dlc;
+    frame->timestamp_us = ts->hardware_us;
+    frame->timestamp_host_ns = ts->hardware_host_ns;
+    frame->receive_host_ns = ts->receive_host_ns;
+    frame->tag = ts->tag;
+
+    if (hf->flags & GS_CAN_FLAG_FD)
+        memcpy(frame->data, hf->canfd->data, dlc2len[hf->can_dlc]);
+    else
+        memcpy(frame->data, hf->classic_can->data, dlc2len[hf->can_dlc]);
+}
+
+static bool rx_queue_put(struct candle_channel_handle *ch, struct gs_host_frame *hf, const struct rx_meta *ts) {
+    // convert straight into the ring slot, readers may use it in place
+    if (ch->rx_ring != NULL) {
+        struct candle_can_frame *slot = spsc_write_slot(ch->rx_ring);
+        if (slot == NULL) {
+            stat_inc(&ch->rx_dropped);
+            return false;
+        }
+        convert_frame(hf, slot, ts);
+        spsc_write_commit(ch->rx_ring);
+        return true;
+    }
+
+    struct candle_can_frame frame;
+    convert_frame(hf, &frame, ts);
+
+    fifo_t *rx_fifo = ch->rx_fifo;
+    bool r = true;
+    MUTEX_LOCK(rx_fifo->mutex);
+    if (fifo_is_full(rx_fifo)) {
+        stat_inc(&ch->rx_dropped);
+        switch (ch->rx_overflow_policy) {
+            case CANDLE_RX_OVERFLOW_DROP_OLDEST:
+                // discard the oldest frame to make room
+                fifo_drop_oldest_noprotect(rx_fifo);
+                fifo_put_noprotect(rx_fifo, &frame);
+                break;
+            default:
+                r = false;
+        }
+    } else
+        fifo_put_noprotect(rx_fifo, &frame);
+    MUTEX_UNLOCK(rx_fifo->mutex);
+    return r;
+}
+
+static bool rx_queue_get(struct candle_channel_handle *ch, struct candle_can_frame *frame) {
+    if (ch->rx_ring != NULL)
+        return spsc_get(ch->rx_ring, frame) == 0;
+    return fifo_get(ch->rx_fifo, frame) == 0;
+}
+
+static size_t rx_queue_used(struct candle_channel_handle *ch) {
+    if (ch->rx_ring != NULL)
+        return spsc_used(ch->rx_ring);
+
+    // the event thread updates the locked queue's count under its mutex
+    MUTEX_LOCK(ch->rx_fifo->mutex);
+    size_t used = (size_t)fifo_used(ch->rx_fifo);
+    MUTEX_UNLOCK(ch->rx_fifo->mutex);
+    return used;
+}
+
+static bool rx_queue_is_empty(struct candle_channel_handle *ch) {
+    if (ch->rx_ring != NULL)
+        return spsc_is_empty(ch->rx_ring);
+    return rx_queue_used(ch) == 0;
+}
+
+static void rx_queue_flush(struct candle_channel_handle *ch) {
+    if (ch->rx_ring != NULL)
+        spsc_flush(ch->rx_ring);
+    else
+        fifo_flush(ch->rx_fifo);
+}
+
+// consumer side calls run between rx_reader_enter and rx_reader_leave and only on a started channel
+static bool rx_reader_enter(struct candle_channel_handle *ch) {
+    atomic_fetch_add(&ch->rx_readers, 1);
+    if (atomic_load(&ch->is_start))
+        return true;
+    atomic_fetch_sub(&ch->rx_readers, 1);
+    return false;
+}
+
+static void rx_reader_leave(struct candle_channel_handle *ch) {
+    atomic_fetch_sub(&ch->rx_readers, 1);
+}
+
+static void wake_rx_readers(struct candle_channel_handle *ch);
+
+// stop the channel and flush its rx queue once no reader is left, so the flush is the only consumer
+static void rx_queue_stop(struct candle_channel_handle *ch) {
+    atomic_store(&ch->is_start, false);
+    while (atomic_load(&ch->rx_readers) != 0) {
+        // blocked readers recheck is_start after the wake-up and leave
+        wake_rx_readers(ch);
         thrd_yield();
     }
-    thrd_exit(0);
+    ch->rx_peeked = 0;
+    rx_queue_flush(ch);
+}
+
+static void release_echo_id(struct candle_device_handle *handle, uint8_t channel, uint32_t echo_id) {
+    id_pool_release(&handle->channels[channel].echo_id_pool, (int)echo_id);
+    wakeup_signal(&handle->channels[channel].echo_id_wakeup);
+}
+
+static void complete_tx(struct candle_device_handle *handle, uint8_t channel, uint32_t echo_id, struct rx_meta *ts) {
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    struct tx_pending *pending = &ch->tx_pending[echo_id];
+
+    ts->tag = pending->tag;
+    if (ch->tx_callback == NULL)
+        return;
+
+    struct candle_tx_completion completion = {
+        .tag = pending->tag,
+        .timestamp_us = ts->hardware_us,
+        .timestamp_host_ns = ts->hardware_host_ns,
+        .scheduled_host_ns = pending->scheduled_host_ns,
+        .submit_host_ns = pending->submit_host_ns,
+        .submit_lateness_ns = pending->scheduled_host_ns != 0 ? pending->submit_host_ns - pending->scheduled_host_ns : 0,
+        .echo_host_ns = ts->receive_host_ns,
+        .latency_ns = ts->receive_host_ns - pending->submit_host_ns
+    };
+    ch->tx_callback(handle->device, channel, &completion, ch->tx_callback_user);
+}
+
+static uint32_t arbitration_key(const struct candle_can_frame *frame) {
+    // bus order: base id, RTR (SRR), IDE, id extension, RTR, the dominant (lower) bit wins
+    uint32_t rtr = frame->type & CANDLE_FRAME_TYPE_RTR ? 1 : 0;
+    if (frame->type & CANDLE_FRAME_TYPE_EFF)
+        return (frame->can_id >> 18 & 0x7FF) << 21 | 1u << 20 | 1u << 19 | (frame->can_id & 0x3FFFF) << 1 | rtr;
+    return (frame->can_id & 0x7FF) << 21 | rtr << 20;
+}
+
+static bool send_frame(struct candle_device_handle* handle, uint8_t channel, struct candle_can_frame *frame, uint32_t echo_id, uint64_t scheduled_ns);
+static int wait_for_wakeup(wakeup_t *w, uint64_t deadline_ns);
+
+// move queued frames into the echo id window, highest priority first
+static void tx_queue_drain(struct candle_device_handle *handle, uint8_t channel) {
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    struct candle_tx_queue_stats *stats = &ch->tx_queue_stats;
+    bool moved = false;
+
+    mtx_lock(&ch->tx_queue_mtx);
+    while (!prio_queue_is_empty(ch->tx_queue)) {
+        int echo_id = id_pool_acquire(&ch->echo_id_pool);
+        if (echo_id < 0)
+            break;
+
+        struct tx_queue_entry entry;
+        prio_queue_get(ch->tx_queue, &entry);
+        moved = true;
+
+        uint32_t prio_class = arbitration_key(&entry.frame) >> TX_PRIORITY_CLASS_SHIFT;
+        uint64_t delay = clock_monotonic_ns() - entry.enqueue_host_ns;
+        stats->frames[prio_class]++;
+        stats->delay_sum_ns[prio_class] += delay;
+        if (delay > stats->delay_max_ns[prio_class])
+            stats->delay_max_ns[prio_class] = delay;
+
+        // send_frame gives the echo id back on failure
+        if (!send_frame(handle, channel, &entry.frame, (uint32_t)echo_id, entry.scheduled_host_ns))
+            stats->send_errors++;
+    }
+    mtx_unlock(&ch->tx_queue_mtx);
+
+    if (moved)
+        wakeup_broadcast(&ch->tx_queue_wakeup);
+}
+
+// queue a frame, waiting for space until deadline (NULL to fail at once)
+static bool tx_queue_put(struct candle_device_handle *handle, uint8_t channel, struct candle_can_frame *frame, uint64_t deadline_ns, uint64_t scheduled_ns) {
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    struct tx_queue_entry entry = {.enqueue_host_ns = clock_monotonic_ns(), .scheduled_host_ns = scheduled_ns, .frame = *frame};
+    uint32_t key = arbitration_key(frame);
+
+    mtx_lock(&ch->tx_queue_mtx);
+    int rc = prio_queue_put(ch->tx_queue, key, &entry);
+    if (rc != 0)
+        ch->tx_queue_stats.queue_full++;
+    mtx_unlock(&ch->tx_queue_mtx);
+
+    if (rc != 0) {
+        if (deadline_ns == 0)
+            return false;
+
+        wakeup_lock(&ch->tx_queue_wakeup);
+        while (rc != 0) {
+            if (wait_for_wakeup(&ch->tx_queue_wakeup, deadline_ns) != thrd_success) {
+                wakeup_unlock(&ch->tx_queue_wakeup);
+                return false;
+            }
+            mtx_lock(&ch->tx_queue_mtx);
+            rc = prio_queue_put(ch->tx_queue, key, &entry);
+            mtx_unlock(&ch->tx_queue_mtx);
+        }
+        wakeup_unlock(&ch->tx_queue_wakeup);
+    }
+
+    tx_queue_drain(handle, channel);
+    return true;
+}
+
+static void tx_queue_flush(struct candle_channel_handle *ch) {
+    if (ch->tx_queue == NULL)
+        return;
+
+    mtx_lock(&ch->tx_queue_mtx);
+    prio_queue_flush(ch->tx_queue);
+    mtx_unlock(&ch->tx_queue_mtx);
+    wakeup_broadcast(&ch->tx_queue_wakeup);
 }
 
-static void after_libusb_open_hook(void) {
-    open_device_count++;
-    if (open_device_count == 1) {
-        // start event loop
-        event_thread_run = true;
-        thrd_create(&event_thread, event_thread_func, ctx);
+static void release_rx_transfer(struct candle_device_handle *handle, struct libusb_transfer *transfer) {
+    for (size_t i = 0; i < handle->rx_transfer_count; ++i) {
+        if (handle->rx_transfers[i] == transfer)
+            handle->rx_transfers[i] = NULL;
     }
+    free(transfer->buffer);
+    libusb_free_transfer(transfer);
 }
 
-static void before_libusb_close_hook(void) {
-    open_device_count--;
-    if (open_device_count == 0) {
-        // stop event loop
-        event_thread_run = false;
+static void cancel_rx_transfers(struct candle_device_handle *handle) {
+    for (size_t i = 0; i < handle->rx_transfer_count; ++i) {
+        if (handle->rx_transfers[i] != NULL) {
+            libusb_cancel_transfer(handle->rx_transfers[i]);
+            handle->rx_transfers[i] = NULL;
+        }
     }
 }
 
-static void after_libusb_close_hook(void) {
-    if (open_device_count == 0) {
-        // join event loop
-        thrd_join(event_thread, NULL);
+// hand a received frame to its started channel, between channel_callback_enter and channel_callback_leave
+static void deliver_frame(struct candle_device_handle *handle, uint8_t ch, struct gs_host_frame *hf, uint64_t host_ns) {
+    stat_inc(&handle->channels[ch].rx_frames);
+    if (hf->flags & GS_CAN_FLAG_OVERFLOW)
+        stat_inc(&handle->channels[ch].device_overflows);
+
+    // timestamp every frame here, completions arrive in order
+    struct rx_meta ts;
+    capture_timestamp(handle, &handle->channels[ch], hf, host_ns, &ts);
+
+    // report tx completion and release echo id (the pending entry is reused after that)
+    if (hf->echo_id < 32) {
+        complete_tx(handle, ch, hf->echo_id, &ts);
+        release_echo_id(handle, ch, hf->echo_id);
+        if (handle->channels[ch].tx_queue != NULL)
+            tx_queue_drain(handle, ch);
+    }
+
+    // drop unwanted frames before paying for the copy and the wake-up
+    rx_filter_t *filter = atomic_load_explicit(&handle->channels[ch].rx_filter, memory_order_acquire);
+    if (filter != NULL) {
+        if (!rx_filter_match(filter, hf->can_id, hf->can_id & CAN_EFF_FLAG, hf->can_id & CAN_RTR_FLAG, hf->can_id & CAN_ERR_FLAG)) {
+            stat_inc(&handle->channels[ch].rx_filter_rejected);
+            return;
+        }
+        stat_inc(&handle->channels[ch].rx_filter_accepted);
+    }
+
+    if (handle->channels[ch].rx_callback != NULL) {
+        // hand over to the user on this thread, bypassing the rx queue
+        struct candle_can_frame frame;
+        convert_frame(hf, &frame, &ts);
+        handle->channels[ch].rx_callback(handle->device, ch, &frame, handle->channels[ch].rx_callback_user);
+    } else if (rx_queue_put(&handle->channels[ch], hf, &ts)) {
+        // notify channel and device readers only if one is waiting
+        wakeup_signal(&handle->channels[ch].rx_wakeup);
+        wakeup_signal(&handle->rx_wakeup);
+        if (atomic_load_explicit(&handle->event_fd_state, memory_order_acquire) == EVENT_FD_OPEN)
+            event_fd_notify(&handle->event_fd);
     }
 }
 
 static void LIBUSB_CALL receive_bulk_callback(struct libusb_transfer *transfer) {
+    // as close to the wire as the host gets
+    uint64_t host_ns = clock_monotonic_ns();
+
     struct candle_device_handle *handle = transfer->user_data;
     struct gs_host_frame *hf = (struct gs_host_frame *)transfer->buffer;
     uint8_t ch = hf->channel;
 
     switch (transfer->status) {
         case LIBUSB_TRANSFER_COMPLETED:
-            if (ch < handle->device->channel_count && handle->channels[ch].is_start) {
-                // release echo id
-                if (hf->echo_id != 0xFFFFFFFF) {
-                    mtx_lock(&handle->channels[ch].echo_id_cond_mtx);
-                    atomic_fetch_and(&handle->channels[ch].echo_id_pool, ~(1 << hf->echo_id));
-                    cnd_signal(&handle->channels[ch].echo_id_cnd);
-                    mtx_unlock(&handle->channels[ch].echo_id_cond_mtx);
-                }
-
-                // put in fifo
-                fifo_put(handle->channels[ch].rx_fifo, hf);
-
-                // channel rx notification
-                mtx_lock(&handle->channels[ch].rx_cond_mtx);
-                cnd_signal(&handle->channels[ch].rx_cnd);
-                mtx_unlock(&handle->channels[ch].rx_cond_mtx);
-
-                // device rx notification
-                mtx_lock(&handle->rx_cond_mtx);
-                cnd_signal(&handle->rx_cnd);
-                mtx_unlock(&handle->rx_cond_mtx);
+            if (ch < handle->device->channel_count && channel_callback_enter(&handle->channels[ch])) {
+                deliver_frame(handle, ch, hf, host_ns);
+                channel_callback_leave(&handle->channels[ch]);
             }
-            libusb_submit_transfer(transfer);
             break;
         case LIBUSB_TRANSFER_CANCELLED:
-            free(transfer->buffer);
-            libusb_free_transfer(transfer);
-            handle->rx_transfer = NULL;
-            break;
+            release_rx_transfer(handle, transfer);
+            return;
         case LIBUSB_TRANSFER_NO_DEVICE:
             handle->device->is_connected = false;
-            free(transfer->buffer);
-            libusb_free_transfer(transfer);
-            handle->rx_transfer = NULL;
+            release_rx_transfer(handle, transfer);
+            return;
+        case LIBUSB_TRANSFER_TIMED_OUT:
+            stat_inc(&handle->rx_usb_resubmits);
             break;
         default:
-            libusb_submit_transfer(transfer);
+            stat_inc(&handle->rx_usb_errors);
+            stat_inc(&handle->rx_usb_resubmits);
+    }
+
+    // a transfer that cannot be resubmitted is lost for good
+    if (libusb_submit_transfer(transfer) != LIBUSB_SUCCESS) {
+        stat_inc(&handle->rx_usb_errors);
+        release_rx_transfer(handle, transfer);
+    }
+}
+
+static struct candle_tx_slot *acquire_tx_slot(struct candle_device_handle *handle, uint8_t channel) {
+    struct candle_channel_handle *ch = &handle->channels[channel];
+
+    // take a pre-built transfer from the pool
+    int index = id_pool_acquire(&ch->tx_slot_pool);
+    if (index >= 0)
+        return &ch->tx_slots[index];
+
+    // pool exhausted (slot will be free in transmit_bulk_callback)
+    atomic_fetch_add_explicit(&ch->tx_pool_exhausted, 1, memory_order_relaxed);
+    struct candle_tx_slot *slot = malloc(sizeof(struct candle_tx_slot));
+    if (slot == NULL)
+        return NULL;
+    slot->handle = handle;
+    slot->channel = channel;
+    slot->index = -1;
+    slot->transfer = libusb_alloc_transfer(0);
+    if (slot->transfer == NULL) {
+        free(slot);
+        return NULL;
+    }
+    slot->transfer->buffer = malloc(handle->tx_size);
+    if (slot->transfer->buffer == NULL) {
+        libusb_free_transfer(slot->transfer);
+        free(slot);
+        return NULL;
+    }
+    return slot;
+}
+
+static void release_tx_slot(struct candle_tx_slot *slot) {
+    if (slot->index < 0) {
+        free(slot->transfer->buffer);
+        libusb_free_transfer(slot->transfer);
+        free(slot);
+        return;
+    }
+
+    id_pool_release(&slot->handle->channels[slot->channel].tx_slot_pool, slot->index);
+}
+
+static void free_tx_slots(struct candle_channel_handle *ch) {
+    for (int j = 0; j < TX_SLOT_COUNT; ++j) {
+        libusb_free_transfer(ch->tx_slots[j].transfer);
+        ch->tx_slots[j].transfer = NULL;
     }
+    free(ch->tx_buffers);
+    ch->tx_buffers = NULL;
+}
+
+static bool alloc_tx_slots(struct candle_device_handle *handle) {
+    for (int i = 0; i < handle->device->channel_count; ++i) {
+        struct candle_channel_handle *ch = &handle->channels[i];
+
+        // already allocated by a previous open
+        if (ch->tx_buffers != NULL)
+            continue;
+
+        ch->tx_buffers = malloc(TX_SLOT_COUNT * handle->tx_size);
+        if (ch->tx_buffers == NULL)
+            return false;
+
+        for (int j = 0; j < TX_SLOT_COUNT; ++j) {
+            ch->tx_slots[j].transfer = libusb_alloc_transfer(0);
+            if (ch->tx_slots[j].transfer == NULL) {
+                free_tx_slots(ch);
+                return false;
+            }
+            ch->tx_slots[j].transfer->buffer = ch->tx_buffers + j * handle->tx_size;
+        }
+        atomic_store(&ch->tx_slot_pool, 0);
+    }
+    return true;
 }
 
 static void LIBUSB_CALL transmit_bulk_callback(struct libusb_transfer *transfer) {
-    struct candle_device_handle *handle = transfer->user_data;
+    struct candle_tx_slot *slot = transfer->user_data;
 
     switch (transfer->status) {
         case LIBUSB_TRANSFER_COMPLETED:
         case LIBUSB_TRANSFER_CANCELLED:
-            free(transfer->buffer);
-            libusb_free_transfer(transfer);
+            release_tx_slot(slot);
             break;
         case LIBUSB_TRANSFER_NO_DEVICE:
-            free(transfer->buffer);
-            libusb_free_transfer(transfer);
-            handle->device->is_connected = false;
+            slot->handle->device->is_connected = false;
+            release_tx_slot(slot);
             break;
         default:
-            libusb_submit_transfer(transfer);
+            if (transfer->status != LIBUSB_TRANSFER_TIMED_OUT)
+                stat_inc(&slot->handle->channels[slot->channel].tx_usb_errors);
+            stat_inc(&slot->handle->channels[slot->channel].tx_usb_resubmits);
+            if (libusb_submit_transfer(transfer) != LIBUSB_SUCCESS) {
+                // an on-demand slot is freed on release, keep what the drain needs
+                struct candle_device_handle *handle = slot->handle;
+                uint8_t channel = slot->channel;
+
+                // the frame will never be echoed, give its echo id back
+                stat_inc(&handle->channels[channel].tx_usb_errors);
+                release_echo_id(handle, channel, ((struct gs_host_frame *)transfer->buffer)->echo_id);
+                release_tx_slot(slot);
+                if (channel_callback_enter(&handle->channels[channel])) {
+                    if (handle->channels[channel].tx_queue != NULL)
+                        tx_queue_drain(handle, channel);
+                    channel_callback_leave(&handle->channels[channel]);
+                }
+            }
     }
 }
 
 static void free_device(struct candle_device_handle* handle) {
     list_del(&handle->list);
-    if (handle->rx_transfer != NULL) {
-        libusb_cancel_transfer(handle->rx_transfer);
-    }
+    cyclic_destroy(atomic_exchange(&handle->cyclic, NULL));
+    cancel_rx_transfers(handle);
     if (handle->usb_device_handle != NULL) {
         struct gs_device_mode md = {.mode = 0};
         for (int i = 0; i < handle->device->channel_count; ++i) {
@@ -153,60 +673,30 @@ static void free_device(struct candle_device_handle* handle) {
                                     GS_USB_BREQ_MODE, i, 0, (uint8_t *) &md, sizeof(md), 1000);
         }
         libusb_release_interface(handle->usb_device_handle, 0);
-        before_libusb_close_hook();
+        event_group_before_close(handle->event_group);
         libusb_close(handle->usb_device_handle);
-        after_libusb_close_hook();
+        event_group_after_close(handle->event_group);
+        event_group_put(handle->event_group);
     }
     for (int i = 0; i < handle->device->channel_count; ++i) {
-        fifo_destroy(handle->channels[i].rx_fifo);
-        cnd_destroy(&handle->channels[i].rx_cnd);
-        mtx_destroy(&handle->channels[i].rx_cond_mtx);
-        cnd_destroy(&handle->channels[i].echo_id_cnd);
-        mtx_destroy(&handle->channels[i].echo_id_cond_mtx);
-    }
-    cnd_destroy(&handle->rx_cnd);
-    mtx_destroy(&handle->rx_cond_mtx);
+        free_tx_slots(&handle->channels[i]);
+        destroy_rx_queue(&handle->channels[i]);
+        rx_filter_destroy(atomic_load(&handle->channels[i].rx_filter));
+        wakeup_destroy(&handle->channels[i].rx_wakeup);
+        wakeup_destroy(&handle->channels[i].echo_id_wakeup);
+        prio_queue_destroy(handle->channels[i].tx_queue);
+        mtx_destroy(&handle->channels[i].tx_queue_mtx);
+        wakeup_destroy(&handle->channels[i].tx_queue_wakeup);
+    }
+    wakeup_destroy(&handle->rx_wakeup);
+    if (atomic_load(&handle->event_fd_state) == EVENT_FD_OPEN)
+        event_fd_close(&handle->event_fd);
     libusb_unref_device(handle->usb_device);
     free(handle->device);
     free(handle);
 }
 
-static void convert_frame(struct gs_host_frame *hf, struct candle_can_frame *frame, bool hw_timestamp) {
-    frame->type = 0;
-    if (hf->echo_id == 0xFFFFFFFF)
-        frame->type |= CANDLE_FRAME_TYPE_RX;
-    if (hf->can_id & CAN_EFF_FLAG)
-        frame->type |= CANDLE_FRAME_TYPE_EFF;
-    if (hf->can_id & CAN_RTR_FLAG)
-        frame->type |= CANDLE_FRAME_TYPE_RTR;
-    if (hf->can_id & CAN_ERR_FLAG)
-        frame->type |= CANDLE_FRAME_TYPE_ERR;
-    if (hf->flags & GS_CAN_FLAG_FD)
-        frame->type |= CANDLE_FRAME_TYPE_FD;
-    if (hf->flags & GS_CAN_FLAG_BRS)
-        frame->type |= CANDLE_FRAME_TYPE_BRS;
-    if (hf->flags & GS_CAN_FLAG_ESI)
-        frame->type |= CANDLE_FRAME_TYPE_ESI;
-
-    if (hf->can_id & CAN_EFF_FLAG)
-        frame->can_id = hf->can_id & 0x1FFFFFFF;
-    else
-        frame->can_id = hf->can_id & 0x7FF;
-
-    frame->can_dlc = hf->can_dlc;
-
-    if (hf->flags & GS_CAN_FLAG_FD) {
-        memcpy(frame->data, hf->canfd->data, dlc2len[hf->can_dlc]);
-        if (hw_timestamp)
-            frame->timestamp_us = hf->canfd_ts->timestamp_us;
-    } else {
-        memcpy(frame->data, hf->classic_can->data, dlc2len[hf->can_dlc]);
-        if (hw_timestamp)
-            frame->timestamp_us = hf->classic_can_ts->timestamp_us;
-    }
-}
-
-static bool send_frame(struct candle_device_handle* handle, uint8_t channel, struct candle_can_frame *frame, uint32_t echo_id) {
+static bool send_frame(struct candle_device_handle* handle, uint8_t channel, struct candle_can_frame *frame, uint32_t echo_id, uint64_t scheduled_ns) {
     // calculate tx size
     struct gs_host_frame *hf;
     size_t hf_size_tx;
@@ -222,10 +712,13 @@ static bool send_frame(struct candle_device_handle* handle, uint8_t channel, str
             hf_size_tx = struct_size(hf, classic_can, 1);
     }
 
-    // allocate frame buffer (buffer will be free in transmit_bulk_callback)
-    hf = malloc(hf_size_tx);
-    if (hf == NULL)
+    // take transfer from pool (transfer will be returned in transmit_bulk_callback)
+    struct candle_tx_slot *slot = acquire_tx_slot(handle, channel);
+    if (slot == NULL) {
+        release_echo_id(handle, channel, echo_id);
         return false;
+    }
+    hf = (struct gs_host_frame *)slot->transfer->buffer;
 
     hf->echo_id = echo_id;
 
@@ -250,6 +743,11 @@ static bool send_frame(struct candle_device_handle* handle, uint8_t channel, str
 
     hf->reserved = 0;
 
+    // read back on the event thread when the echo arrives
+    struct tx_pending *pending = &handle->channels[channel].tx_pending[echo_id];
+    pending->tag = frame->tag;
+    pending->scheduled_host_ns = scheduled_ns;
+
     size_t data_length = dlc2len[frame->can_dlc];
 
     if (frame->type & CANDLE_FRAME_TYPE_FD)
@@ -257,44 +755,130 @@ static bool send_frame(struct candle_device_handle* handle, uint8_t channel, str
     else
         memcpy(hf->classic_can->data, frame->data, data_length);
 
-    // allocate transfer (transfer will be free in transmit_bulk_callback)
-    struct libusb_transfer *transfer = libusb_alloc_transfer(0);
-    if (transfer == NULL) {
-        free(hf);
-        return false;
-    }
-
     // submit transfer
-    libusb_fill_bulk_transfer(transfer, handle->usb_device_handle, handle->out_ep, (uint8_t *)hf, (int)hf_size_tx,
-                              transmit_bulk_callback, handle, 1000);
-    int rc = libusb_submit_transfer(transfer);
+    libusb_fill_bulk_transfer(slot->transfer, handle->usb_device_handle, handle->out_ep, (uint8_t *)hf, (int)hf_size_tx,
+                              transmit_bulk_callback, slot, 1000);
+    pending->submit_host_ns = clock_monotonic_ns();
+    int rc = libusb_submit_transfer(slot->transfer);
     if (rc != LIBUSB_SUCCESS) {
         if (rc == LIBUSB_ERROR_NO_DEVICE)
             handle->device->is_connected = false;
-        free(hf);
-        libusb_free_transfer(transfer);
+        release_tx_slot(slot);
+        release_echo_id(handle, channel, echo_id);
+        return false;
     }
 
     return true;
 }
 
-static void milliseconds_to_timespec(uint32_t milliseconds, struct timespec *ts) {
-    timespec_get(ts, TIME_UTC);
-    ts->tv_sec += milliseconds / 1000;
-    ts->tv_nsec += (long)(milliseconds % 1000) * 1000000;
+// deadline on the monotonic clock, saturating for very long timeouts
+static uint64_t deadline_after_us(uint64_t microseconds) {
+    uint64_t now = clock_monotonic_ns();
+    if (microseconds > (UINT64_MAX - now) / 1000)
+        return UINT64_MAX;
+    return now + microseconds * 1000;
+}
+
+
+// End of the busy poll window of a receiver, never after its deadline; 0 if it should sleep right away.
+static uint64_t busy_poll_end(struct candle_device_handle *handle, uint64_t deadline_ns) {
+    uint64_t spin_ns = atomic_load_explicit(&handle->busy_poll_ns, memory_order_relaxed);
+    if (spin_ns == 0)
+        return 0;
+    return min(clock_monotonic_ns() + spin_ns, deadline_ns);
+}
+
+// One step of a receiver's busy poll, false once the window is over. The waking
+// event thread is the latency being avoided; without one the receiver polls usb itself.
+static bool busy_poll_step(uint64_t end_ns) {
+    if (app_driven) {
+        struct timeval zero = {0, 0};
+        libusb_handle_events_timeout_completed(ctx, &zero, NULL);
+    } else {
+        cpu_relax();
+    }
+    return clock_monotonic_ns() < end_ns;
+}
 
-    if (ts->tv_nsec > 1000000000) {
-        ts->tv_nsec -= 1000000000;
-        ts->tv_sec += 1;
+// Wait on w with its mutex held (between wakeup_lock and wakeup_unlock) until deadline_ns on the
+// monotonic clock. Without an event thread the transfers only complete while somebody handles
+// events, so the waiter handles them itself until the deadline. Either way the caller re-checks
+// its condition after thrd_success.
+static int wait_for_wakeup(wakeup_t *w, uint64_t deadline_ns) {
+    uint64_t now = clock_monotonic_ns();
+    if (now >= deadline_ns)
+        return thrd_timedout;
+
+    if (app_driven) {
+        // the completion signals w from this thread, which must not hold its mutex then
+        uint64_t remaining_us = (deadline_ns - now + 999) / 1000;
+        struct timeval tv = {.tv_sec = (long)(remaining_us / 1000000), .tv_usec = (long)(remaining_us % 1000000)};
+        wakeup_suspend(w);
+        int rc = libusb_handle_events_timeout_completed(ctx, &tv, NULL);
+        wakeup_resume(w);
+        return rc == LIBUSB_SUCCESS ? thrd_success : thrd_error;
     }
+
+    return wakeup_wait_until(w, deadline_ns);
+}
+
+static void wake_rx_readers(struct candle_channel_handle *ch) {
+    // readers in application driven mode wait inside the event handler
+    if (app_driven)
+        libusb_interrupt_event_handler(ctx);
+    else
+        wakeup_broadcast(&ch->rx_wakeup);
 }
 
 bool candle_initialize(void) {
-    if (ctx == NULL && libusb_init_context(&ctx, NULL, 0) == LIBUSB_SUCCESS)
+    return candle_initialize_ex(CANDLE_EVENT_MODE_THREAD);
+}
+
+bool candle_initialize_ex(enum candle_event_mode mode) {
+    if (mode > CANDLE_EVENT_MODE_APPLICATION)
+        return false;
+
+    if (ctx == NULL && libusb_init_context(&ctx, NULL, 0) == LIBUSB_SUCCESS) {
+        app_driven = mode == CANDLE_EVENT_MODE_APPLICATION;
         return true;
+    }
     return false;
 }
 
+bool candle_handle_events(uint32_t timeout_us) {
+    // the event threads do this unless initialized application-driven
+    if (ctx == NULL || !app_driven)
+        return false;
+
+    struct timeval tv = {.tv_sec = (long)(timeout_us / 1000000), .tv_usec = (long)(timeout_us % 1000000)};
+    return libusb_handle_events_timeout_completed(ctx, &tv, NULL) == LIBUSB_SUCCESS;
+}
+
+bool candle_get_pollfds(struct candle_pollfd *fds, size_t max_count, size_t *count) {
+    *count = 0;
+
+    if (ctx == NULL || !app_driven)
+        return false;
+
+    // not supported on Windows
+    const struct libusb_pollfd **pollfds = libusb_get_pollfds(ctx);
+    if (pollfds == NULL)
+        return false;
+
+    size_t n = 0;
+    for (; pollfds[n] != NULL; ++n) {
+        if (n < max_count) {
+            fds[n].fd = pollfds[n]->fd;
+            fds[n].events = pollfds[n]->events;
+        }
+    }
+    libusb_free_pollfds(pollfds);
+
+    // count tells the caller how many it needs
+    *count = n;
+    return n <= max_count;
+}
+
 void candle_finalize(void) {
     if (ctx == NULL)
         return;
@@ -306,6 +890,7 @@ void candle_finalize(void) {
     }
     libusb_exit(ctx);
     ctx = NULL;
+    app_driven = false;
 }
 
 bool candle_get_device_list(struct candle_device ***devices, size_t *size) {
@@ -358,10 +943,7 @@ bool candle_get_device_list(struct candle_device ***devices, size_t *size) {
                     continue;
                 };
 
-                // libusb open close hook
-                after_libusb_open_hook();
-
-                // read usb descriptions
+                // read usb descriptions (synchronous control transfers, no event thread needed)
                 struct candle_device candle_dev;
                 candle_dev.is_connected = true;
                 candle_dev.is_open = false;
@@ -489,6 +1071,13 @@ bool candle_get_device_list(struct candle_device ***devices, size_t *size) {
                     rx_size = max(rx_size, rx_hf_size);
                 }
 
+                // calculate tx size (largest frame any channel can send)
+                size_t tx_size = struct_size(hf, classic_can_quirk, 1);
+                for (int j = 0; j < channel_count; ++j) {
+                    if (new_candle_device->channels[j].feature & CANDLE_FEATURE_FD)
+                        tx_size = max(tx_size, struct_size(hf, canfd_quirk, 1));
+                }
+
                 // create internal handle
                 struct candle_device_handle *handle = malloc(sizeof(struct candle_device_handle) + channel_count * sizeof(struct candle_channel_handle));
                 if (handle == NULL) {
@@ -498,24 +1087,63 @@ bool candle_get_device_list(struct candle_device ***devices, size_t *size) {
                 handle->device = new_candle_device;
                 handle->usb_device = libusb_ref_device(dev);
                 handle->usb_device_handle = NULL;
-                handle->rx_transfer = NULL;
+                memset(handle->rx_transfers, 0, sizeof(handle->rx_transfers));
+                handle->rx_transfer_count = RX_TRANSFER_COUNT_DEFAULT;
+                atomic_init(&handle->rx_usb_errors, 0);
+                atomic_init(&handle->rx_usb_resubmits, 0);
                 handle->ref_count = 1;  // ref once
                 handle->rx_size = rx_size;
+                handle->tx_size = tx_size;
                 handle->in_ep = in_ep;
                 handle->out_ep = out_ep;
-                cnd_init(&handle->rx_cnd);
-                mtx_init(&handle->rx_cond_mtx, mtx_plain);
+                wakeup_init(&handle->rx_wakeup);
+                atomic_init(&handle->busy_poll_ns, 0);
+                atomic_init(&handle->event_fd_state, EVENT_FD_CLOSED);
+                clock_sync_reset(&handle->clock_sync);
+                atomic_init(&handle->cyclic, NULL);
+                handle->event_thread = (struct candle_event_thread_config){.policy = CANDLE_EVENT_THREAD_SHARED, .shard = 0, .cpu = -1, .priority = 0, .busy_poll_us = 0};
+                handle->event_group = NULL;
 
                 // create internal channel handle
                 for (int j = 0; j < channel_count; ++j) {
-                    handle->channels[j].is_start = false;
+                    atomic_init(&handle->channels[j].is_start, false);
+                    atomic_init(&handle->channels[j].rx_readers, 0);
+                    atomic_init(&handle->channels[j].in_callback, 0);
+                    handle->channels[j].rx_peeked = 0;
                     handle->channels[j].mode = CANDLE_MODE_NORMAL;
-                    handle->channels[j].rx_fifo = fifo_create((char)rx_size, 1024); // no more than 81920 bytes plus sizeof(fifo_t)
-                    cnd_init(&handle->channels[j].rx_cnd);
-                    mtx_init(&handle->channels[j].rx_cond_mtx, mtx_plain);
-                    cnd_init(&handle->channels[j].echo_id_cnd);
-                    mtx_init(&handle->channels[j].echo_id_cond_mtx, mtx_plain);
+                    handle->channels[j].rx_fifo = NULL;
+                    handle->channels[j].rx_ring = NULL;
+                    handle->channels[j].rx_callback = NULL;
+                    handle->channels[j].rx_callback_user = NULL;
+                    atomic_init(&handle->channels[j].rx_filter, NULL);
+                    handle->channels[j].tx_callback = NULL;
+                    handle->channels[j].tx_callback_user = NULL;
+                    handle->channels[j].tx_queue = NULL;
+                    handle->channels[j].tx_queue_depth = 0;
+                    mtx_init(&handle->channels[j].tx_queue_mtx, mtx_plain);
+                    wakeup_init(&handle->channels[j].tx_queue_wakeup);
+                    memset(&handle->channels[j].tx_queue_stats, 0, sizeof(struct candle_tx_queue_stats));
+                    clock_unwrap_reset(&handle->channels[j].timestamp);
+                    create_rx_queue(&handle->channels[j], sizeof(struct candle_can_frame), CANDLE_RX_QUEUE_SPSC, CANDLE_RX_OVERFLOW_DROP_NEWEST, RX_QUEUE_DEPTH_DEFAULT);
+                    atomic_init(&handle->channels[j].rx_dropped, 0);
+                    atomic_init(&handle->channels[j].rx_frames, 0);
+                    atomic_init(&handle->channels[j].device_overflows, 0);
+                    atomic_init(&handle->channels[j].rx_filter_accepted, 0);
+                    atomic_init(&handle->channels[j].rx_filter_rejected, 0);
+                    wakeup_init(&handle->channels[j].rx_wakeup);
+                    wakeup_init(&handle->channels[j].echo_id_wakeup);
                     atomic_init(&handle->channels[j].echo_id_pool, 0);
+                    for (int k = 0; k < TX_SLOT_COUNT; ++k) {
+                        handle->channels[j].tx_slots[k].handle = handle;
+                        handle->channels[j].tx_slots[k].transfer = NULL;
+                        handle->channels[j].tx_slots[k].channel = j;
+                        handle->channels[j].tx_slots[k].index = k;
+                    }
+                    handle->channels[j].tx_buffers = NULL;
+                    atomic_init(&handle->channels[j].tx_slot_pool, 0);
+                    atomic_init(&handle->channels[j].tx_pool_exhausted, 0);
+                    atomic_init(&handle->channels[j].tx_usb_errors, 0);
+                    atomic_init(&handle->channels[j].tx_usb_resubmits, 0);
                 }
 
                 // set candle device handle
@@ -525,13 +1153,7 @@ bool candle_get_device_list(struct candle_device ***devices, size_t *size) {
                 list_add_tail(&handle->list, &device_list);
 
 handle_error:
-                // libusb open close hook
-                before_libusb_close_hook();
-
                 libusb_close(dev_handle);
-
-                // libusb open close hook
-                after_libusb_close_hook();
             }
         }
     }
@@ -591,31 +1213,67 @@ void candle_unref_device(struct candle_device *device) {
         free_device(device->handle);
 }
 
-bool candle_open_device(struct candle_device *device) {
-    struct candle_device_handle *handle = device->handle;
+// the device list belongs to the library context, a group with its own context opens the same device there
+static int open_usb_device(struct libusb_device *usb_device, struct libusb_context *group_ctx, struct libusb_device_handle **usb_device_handle) {
+    if (group_ctx == ctx)
+        return libusb_open(usb_device, usb_device_handle);
 
-    // avoid double open
-    if (device->is_open)
-        return false;
+    struct libusb_device **usb_device_list;
+    ssize_t count = libusb_get_device_list(group_ctx, &usb_device_list);
+    if (count < 0)
+        return (int)count;
+
+    int rc = LIBUSB_ERROR_NO_DEVICE;
+    for (ssize_t i = 0; i < count; ++i) {
+        if (libusb_get_bus_number(usb_device_list[i]) == libusb_get_bus_number(usb_device) &&
+            libusb_get_device_address(usb_device_list[i]) == libusb_get_device_address(usb_device)) {
+            rc = libusb_open(usb_device_list[i], usb_device_handle);
+            break;
+        }
+    }
+    libusb_free_device_list(usb_device_list, 1);
+    return rc;
+}
+
+bool candle_open_device(struct candle_device *device) {
+    struct candle_device_handle *handle = device->handle;
+
+    // avoid double open
+    if (device->is_open)
+        return false;
+
+    // context and thread that will handle the transfers of this device, the application drives the
+    // library context for all devices when there are no event threads
+    static const struct candle_event_thread_config app_driven_config = {CANDLE_EVENT_THREAD_SHARED, 0, -1, 0, 0};
+    handle->event_group = event_group_get(ctx, app_driven, app_driven ? &app_driven_config : &handle->event_thread);
+    if (handle->event_group == NULL)
+        return false;
 
     // open usb device
-    int rc = libusb_open(handle->usb_device, &handle->usb_device_handle);
+    int rc = open_usb_device(handle->usb_device, handle->event_group->ctx, &handle->usb_device_handle);
     if (rc != LIBUSB_SUCCESS) {
         if (rc == LIBUSB_ERROR_NO_DEVICE)
             device->is_connected = false;
         handle->usb_device_handle = NULL;
+        event_group_put(handle->event_group);
         return false;
     }
 
-    // libusb open close hook
-    after_libusb_open_hook();
+    // start event thread
+    if (!event_group_after_open(handle->event_group)) {
+        libusb_close(handle->usb_device_handle);
+        handle->usb_device_handle = NULL;
+        event_group_put(handle->event_group);
+        return false;
+    }
 
     // detach kernel driver
     rc = libusb_set_auto_detach_kernel_driver(handle->usb_device_handle, 1);
     if (rc != LIBUSB_SUCCESS && rc != LIBUSB_ERROR_NOT_SUPPORTED) {
-        before_libusb_close_hook();
+        event_group_before_close(handle->event_group);
         libusb_close(handle->usb_device_handle);
-        after_libusb_close_hook();
+        event_group_after_close(handle->event_group);
+        event_group_put(handle->event_group);
         handle->usb_device_handle = NULL;
         return false;
     }
@@ -625,9 +1283,10 @@ bool candle_open_device(struct candle_device *device) {
     if (rc != LIBUSB_SUCCESS) {
         if (rc == LIBUSB_ERROR_NO_DEVICE)
             device->is_connected = false;
-        before_libusb_close_hook();
+        event_group_before_close(handle->event_group);
         libusb_close(handle->usb_device_handle);
-        after_libusb_close_hook();
+        event_group_after_close(handle->event_group);
+        event_group_put(handle->event_group);
         handle->usb_device_handle = NULL;
         return false;
     }
@@ -642,56 +1301,52 @@ bool candle_open_device(struct candle_device *device) {
             if (rc == LIBUSB_ERROR_NO_DEVICE)
                 device->is_connected = false;
             libusb_release_interface(handle->usb_device_handle, 0);
-            before_libusb_close_hook();
+            event_group_before_close(handle->event_group);
             libusb_close(handle->usb_device_handle);
-            after_libusb_close_hook();
+            event_group_after_close(handle->event_group);
+            event_group_put(handle->event_group);
             handle->usb_device_handle = NULL;
             return false;
         }
     }
 
-    // alloc transfer
-    handle->rx_transfer = libusb_alloc_transfer(0);
-    if (handle->rx_transfer == NULL) {
-        libusb_release_interface(handle->usb_device_handle, 0);
-        before_libusb_close_hook();
-        libusb_close(handle->usb_device_handle);
-        after_libusb_close_hook();
-        handle->usb_device_handle = NULL;
-        return false;
-    }
+    // the device clock may have restarted since the last open
+    clock_sync_reset(&handle->clock_sync);
+
+    // alloc tx transfer pool
+    if (!alloc_tx_slots(handle))
+        goto handle_error;
+
+    // alloc transfers
+    for (size_t i = 0; i < handle->rx_transfer_count; ++i) {
+        handle->rx_transfers[i] = libusb_alloc_transfer(0);
+        uint8_t *fb = malloc(handle->rx_size);
+        if (handle->rx_transfers[i] == NULL || fb == NULL) {
+            free(fb);
+            libusb_free_transfer(handle->rx_transfers[i]);
+            handle->rx_transfers[i] = NULL;
+            goto handle_error;
+        }
 
-    // alloc frame buffer
-    uint8_t *fb = malloc(handle->rx_size);
-    if (fb == NULL) {
-        libusb_free_transfer(handle->rx_transfer);
-        handle->rx_transfer = NULL;
-        libusb_release_interface(handle->usb_device_handle, 0);
-        before_libusb_close_hook();
-        libusb_close(handle->usb_device_handle);
-        after_libusb_close_hook();
-        handle->usb_device_handle = NULL;
-        return false;
+        // fill transfer
+        libusb_fill_bulk_transfer(handle->rx_transfers[i], handle->usb_device_handle, handle->in_ep,
+                                  fb, (int) handle->rx_size, receive_bulk_callback, handle, 1000);
     }
 
-    // fill transfer
-    libusb_fill_bulk_transfer(handle->rx_transfer, handle->usb_device_handle, handle->in_ep,
-                              fb, (int) handle->rx_size, receive_bulk_callback, handle, 1000);
+    // submit transfers (all of them stay in flight and are recycled independently)
+    for (size_t i = 0; i < handle->rx_transfer_count; ++i) {
+        rc = libusb_submit_transfer(handle->rx_transfers[i]);
+        if (rc != LIBUSB_SUCCESS) {
+            if (rc == LIBUSB_ERROR_NO_DEVICE)
+                device->is_connected = false;
 
-    // submit transfer
-    rc = libusb_submit_transfer(handle->rx_transfer);
-    if (rc != LIBUSB_SUCCESS) {
-        if (rc == LIBUSB_ERROR_NO_DEVICE)
-            device->is_connected = false;
-        free(fb);
-        libusb_free_transfer(handle->rx_transfer);
-        handle->rx_transfer = NULL;
-        libusb_release_interface(handle->usb_device_handle, 0);
-        before_libusb_close_hook();
-        libusb_close(handle->usb_device_handle);
-        after_libusb_close_hook();
-        handle->usb_device_handle = NULL;
-        return false;
+            // submitted transfers will be free in receive_bulk_callback
+            for (size_t j = 0; j < i; ++j) {
+                libusb_cancel_transfer(handle->rx_transfers[j]);
+                handle->rx_transfers[j] = NULL;
+            }
+            goto handle_error;
+        }
     }
 
     // increase ref count
@@ -700,6 +1355,57 @@ bool candle_open_device(struct candle_device *device) {
     // success
     device->is_open = true;
     return true;
+
+handle_error:
+    for (size_t i = 0; i < handle->rx_transfer_count; ++i) {
+        if (handle->rx_transfers[i] != NULL) {
+            free(handle->rx_transfers[i]->buffer);
+            libusb_free_transfer(handle->rx_transfers[i]);
+            handle->rx_transfers[i] = NULL;
+        }
+    }
+    libusb_release_interface(handle->usb_device_handle, 0);
+    event_group_before_close(handle->event_group);
+    libusb_close(handle->usb_device_handle);
+    event_group_after_close(handle->event_group);
+    event_group_put(handle->event_group);
+    handle->usb_device_handle = NULL;
+    return false;
+}
+
+bool candle_set_event_thread(struct candle_device *device, const struct candle_event_thread_config *config) {
+    // only configurable while closed
+    if (device->is_open)
+        return false;
+
+    if (config->policy > CANDLE_EVENT_THREAD_SHARDED)
+        return false;
+
+    // there are no threads to configure
+    if (app_driven)
+        return false;
+
+    device->handle->event_thread = *config;
+    return true;
+}
+
+bool candle_set_rx_transfer_count(struct candle_device *device, size_t count) {
+    struct candle_device_handle *handle = device->handle;
+
+    // only configurable while closed
+    if (device->is_open)
+        return false;
+
+    if (count == 0 || count > RX_TRANSFER_COUNT_MAX)
+        return false;
+
+    handle->rx_transfer_count = count;
+    return true;
+}
+
+bool candle_set_busy_poll(struct candle_device *device, uint32_t microseconds) {
+    atomic_store_explicit(&device->handle->busy_poll_ns, (uint64_t)microseconds * 1000, memory_order_relaxed);
+    return true;
 }
 
 void candle_close_device(struct candle_device *device) {
@@ -709,11 +1415,11 @@ void candle_close_device(struct candle_device *device) {
     if (!device->is_open)
         return;
 
-    // cancel transfer (rx_transfer and buffer will be free in receive_bulk_callback)
-    if (handle->rx_transfer != NULL) {
-        libusb_cancel_transfer(handle->rx_transfer);
-        handle->rx_transfer = NULL;
-    }
+    // stop periodic frames before the channels go away
+    cyclic_destroy(atomic_exchange(&handle->cyclic, NULL));
+
+    // cancel transfers (rx_transfers and buffers will be free in receive_bulk_callback)
+    cancel_rx_transfers(handle);
 
     // reset channel (best efforts)
     int rc;
@@ -724,10 +1430,10 @@ void candle_close_device(struct candle_device *device) {
                                      GS_USB_BREQ_MODE, i, 0, (uint8_t *) &md, sizeof(md), 1000);
         if (rc == LIBUSB_ERROR_NO_DEVICE)
             device->is_connected = false;
-        fifo_flush(handle->channels[i].rx_fifo);
+        rx_queue_stop(&handle->channels[i]);
+        tx_queue_flush(&handle->channels[i]);
         atomic_store(&handle->channels[i].echo_id_pool, 0);
         handle->channels[i].mode = CANDLE_MODE_NORMAL;
-        handle->channels[i].is_start = false;
     }
 
     // release interface
@@ -736,9 +1442,11 @@ void candle_close_device(struct candle_device *device) {
         device->is_connected = false;
 
     // close usb device
-    before_libusb_close_hook();
+    event_group_before_close(handle->event_group);
     libusb_close(handle->usb_device_handle);
-    after_libusb_close_hook();
+    event_group_after_close(handle->event_group);
+    event_group_put(handle->event_group);
+    handle->event_group = NULL;
     handle->usb_device_handle = NULL;
 
     // device is closed
@@ -769,10 +1477,10 @@ bool candle_reset_channel(struct candle_device *device, uint8_t channel) {
         return false;
     }
 
-    fifo_flush(handle->channels[channel].rx_fifo);
+    rx_queue_stop(&handle->channels[channel]);
+    tx_queue_flush(&handle->channels[channel]);
     atomic_store(&handle->channels[channel].echo_id_pool, 0);
     handle->channels[channel].mode = CANDLE_MODE_NORMAL;
-    handle->channels[channel].is_start = false;
 
     return true;
 }
@@ -797,11 +1505,164 @@ bool candle_start_channel(struct candle_device *device, uint8_t channel, enum ca
     }
 
     handle->channels[channel].mode = mode;
+    clock_unwrap_reset(&handle->channels[channel].timestamp);
     handle->channels[channel].is_start = true;
 
     return true;
 }
 
+bool candle_set_rx_queue_type(struct candle_device *device, uint8_t channel, enum candle_rx_queue_type type) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    // only configurable while channel is stopped
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->is_start)
+        return false;
+
+    if (ch->rx_queue_type == type)
+        return true;
+
+    return create_rx_queue(ch, sizeof(struct candle_can_frame), type, ch->rx_overflow_policy, ch->rx_queue_depth);
+}
+
+bool candle_set_rx_queue_depth(struct candle_device *device, uint8_t channel, size_t depth) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    // only configurable while channel is stopped
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->is_start)
+        return false;
+
+    return create_rx_queue(ch, sizeof(struct candle_can_frame), ch->rx_queue_type, ch->rx_overflow_policy, depth);
+}
+
+bool candle_set_rx_overflow_policy(struct candle_device *device, uint8_t channel, enum candle_rx_overflow_policy policy) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    // only configurable while channel is stopped
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->is_start)
+        return false;
+
+    if (policy != CANDLE_RX_OVERFLOW_DROP_NEWEST && policy != CANDLE_RX_OVERFLOW_DROP_OLDEST)
+        return false;
+
+    if (ch->rx_overflow_policy == policy)
+        return true;
+
+    return create_rx_queue(ch, sizeof(struct candle_can_frame), ch->rx_queue_type, policy, ch->rx_queue_depth);
+}
+
+bool candle_set_rx_callback(struct candle_device *device, uint8_t channel, candle_rx_callback callback, void *user) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    // only configurable while channel is stopped
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->is_start)
+        return false;
+
+    ch->rx_callback = callback;
+    ch->rx_callback_user = user;
+    return true;
+}
+
+bool candle_set_rx_filters(struct candle_device *device, uint8_t channel, const struct candle_rx_filter *filters, size_t count) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    // only configurable while channel is stopped
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->is_start)
+        return false;
+
+    // no filter accepts everything
+    rx_filter_t *filter = NULL;
+    if (count != 0) {
+        filter = rx_filter_create(filters, count);
+        if (filter == NULL)
+            return false;
+    }
+
+    // free the old filter once the event thread is done with it
+    rx_filter_t *old = atomic_exchange(&ch->rx_filter, filter);
+    channel_quiesce(ch);
+    rx_filter_destroy(old);
+    return true;
+}
+
+bool candle_set_tx_callback(struct candle_device *device, uint8_t channel, candle_tx_callback callback, void *user) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    // only configurable while channel is stopped
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->is_start)
+        return false;
+
+    ch->tx_callback = callback;
+    ch->tx_callback_user = user;
+    return true;
+}
+
+bool candle_set_tx_queue_depth(struct candle_device *device, uint8_t channel, size_t depth) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    // only configurable while channel is stopped
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->is_start)
+        return false;
+
+    prio_queue_t *tx_queue = NULL;
+    if (depth != 0) {
+        tx_queue = prio_queue_create(sizeof(struct tx_queue_entry), depth);
+        if (tx_queue == NULL)
+            return false;
+    }
+
+    // free the old queue once the event thread stopped draining it
+    channel_quiesce(ch);
+    mtx_lock(&ch->tx_queue_mtx);
+    prio_queue_t *old = ch->tx_queue;
+    ch->tx_queue = tx_queue;
+    ch->tx_queue_depth = depth;
+    mtx_unlock(&ch->tx_queue_mtx);
+    prio_queue_destroy(old);
+    return true;
+}
+
+bool candle_get_tx_queue_stats(struct candle_device *device, uint8_t channel, struct candle_tx_queue_stats *stats) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    mtx_lock(&ch->tx_queue_mtx);
+    *stats = ch->tx_queue_stats;
+    stats->queued = ch->tx_queue != NULL ? prio_queue_used(ch->tx_queue) : 0;
+    mtx_unlock(&ch->tx_queue_mtx);
+    return true;
+}
+
 bool candle_set_bit_timing(struct candle_device *device, uint8_t channel, struct candle_bit_timing *bit_timing) {
     struct candle_device_handle *handle = device->handle;
 
@@ -919,7 +1780,7 @@ bool candle_get_state(struct candle_device *device, uint8_t channel, struct cand
     return true;
 }
 
-bool candle_send_frame_nowait(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame) {
+static bool send_frame_nowait(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint64_t scheduled_ns) {
     struct candle_device_handle *handle = device->handle;
 
     if (channel >= device->channel_count)
@@ -934,40 +1795,30 @@ bool candle_send_frame_nowait(struct candle_device *device, uint8_t channel, str
     if (frame->type & CANDLE_FRAME_TYPE_FD && !(device->channels[channel].feature & CANDLE_FEATURE_FD))
         return false;
 
-    // get echo id
-    uint32_t echo_id_pool;
-    uint32_t echo_id = 0;
-    while (true) {
-        // trying to preempt the echo id
-        echo_id_pool = atomic_fetch_or(&handle->channels[channel].echo_id_pool, 1 << echo_id);
-
-        // preempt the echo id
-        if (!(echo_id_pool & (1 << echo_id))) {
-            break;
-        }
+    // frames enter the echo id window in arbitration order
+    if (handle->channels[channel].tx_queue != NULL)
+        return tx_queue_put(handle, channel, frame, 0, scheduled_ns);
 
-        // no echo id available
-        if (echo_id_pool == (uint32_t)(-1)) {
-            return false;
-        }
+    // get echo id
+    int echo_id = id_pool_acquire(&handle->channels[channel].echo_id_pool);
+    if (echo_id < 0)
+        return false;
 
-        // find available echo id
-        for (int i = 0; i < 32; ++i) {
-            if (!(echo_id_pool & (1 << i))) {
-                echo_id = i;
-                break;
-            }
-        }
-    }
+    return send_frame(handle, channel, frame, (uint32_t)echo_id, scheduled_ns);
+}
 
-    return send_frame(handle, channel, frame, echo_id);
+bool candle_send_frame_nowait(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame) {
+    return send_frame_nowait(device, channel, frame, 0);
 }
 
 bool candle_send_frame(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint32_t milliseconds) {
+    return candle_send_frame_us(device, channel, frame, (uint64_t)milliseconds * 1000);
+}
+
+bool candle_send_frame_us(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint64_t microseconds) {
     struct candle_device_handle *handle = device->handle;
 
-    struct timespec ts;
-    milliseconds_to_timespec(milliseconds, &ts);
+    uint64_t deadline_ns = deadline_after_us(microseconds);
 
     if (channel >= device->channel_count)
         return false;
@@ -981,41 +1832,107 @@ bool candle_send_frame(struct candle_device *device, uint8_t channel, struct can
     if (frame->type & CANDLE_FRAME_TYPE_FD && !(device->channels[channel].feature & CANDLE_FEATURE_FD))
         return false;
 
-    // get echo id
-    uint32_t echo_id_pool;
-    uint32_t echo_id = 0;
-    mtx_lock(&handle->channels[channel].echo_id_cond_mtx);
-    while (true) {
-        // trying to preempt the echo id
-        echo_id_pool = atomic_fetch_or(&handle->channels[channel].echo_id_pool, 1 << echo_id);
-
-        // preempt the echo id
-        if (!(echo_id_pool & (1 << echo_id))) {
-            mtx_unlock(&handle->channels[channel].echo_id_cond_mtx);
-            break;
-        }
-
-        // no echo id available
-        while (echo_id_pool == (uint32_t)(-1)) {
-            if (cnd_timedwait(&handle->channels[channel].echo_id_cnd, &handle->channels[channel].echo_id_cond_mtx, &ts) == thrd_success) {
-                echo_id_pool = atomic_load(&handle->channels[channel].echo_id_pool);
-            }
-            else {
-                mtx_unlock(&handle->channels[channel].echo_id_cond_mtx);
+    // frames enter the echo id window in arbitration order
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->tx_queue != NULL)
+        return tx_queue_put(handle, channel, frame, deadline_ns, 0);
+
+    // get echo id, wait only if none is available
+    int echo_id = id_pool_acquire(&ch->echo_id_pool);
+    if (echo_id < 0) {
+        wakeup_lock(&ch->echo_id_wakeup);
+        while ((echo_id = id_pool_acquire(&ch->echo_id_pool)) < 0) {
+            if (wait_for_wakeup(&ch->echo_id_wakeup, deadline_ns) != thrd_success) {
+                wakeup_unlock(&ch->echo_id_wakeup);
                 return false;
             }
         }
+        wakeup_unlock(&ch->echo_id_wakeup);
+    }
 
-        // find available echo id
-        for (int i = 0; i < 32; ++i) {
-            if (!(echo_id_pool & (1 << i))) {
-                echo_id = i;
-                break;
-            }
+    return send_frame(handle, channel, frame, (uint32_t)echo_id, 0);
+}
+
+bool candle_get_channel_stats(struct candle_device *device, uint8_t channel, struct candle_channel_stats *stats) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    stats->tx_pool_exhausted = atomic_load_explicit(&handle->channels[channel].tx_pool_exhausted, memory_order_relaxed);
+    stats->rx_dropped = atomic_load_explicit(&handle->channels[channel].rx_dropped, memory_order_relaxed);
+    stats->rx_frames = atomic_load_explicit(&handle->channels[channel].rx_frames, memory_order_relaxed);
+    stats->device_overflows = atomic_load_explicit(&handle->channels[channel].device_overflows, memory_order_relaxed);
+    stats->tx_usb_errors = atomic_load_explicit(&handle->channels[channel].tx_usb_errors, memory_order_relaxed);
+    stats->tx_usb_resubmits = atomic_load_explicit(&handle->channels[channel].tx_usb_resubmits, memory_order_relaxed);
+    stats->rx_usb_errors = atomic_load_explicit(&handle->rx_usb_errors, memory_order_relaxed);
+    stats->rx_usb_resubmits = atomic_load_explicit(&handle->rx_usb_resubmits, memory_order_relaxed);
+    stats->rx_filter_accepted = atomic_load_explicit(&handle->channels[channel].rx_filter_accepted, memory_order_relaxed);
+    stats->rx_filter_rejected = atomic_load_explicit(&handle->channels[channel].rx_filter_rejected, memory_order_relaxed);
+    return true;
+}
+
+bool candle_send_frames(struct candle_device *device, uint8_t channel, struct candle_can_frame *frames, size_t count, uint32_t milliseconds, size_t *sent) {
+    return candle_send_frames_us(device, channel, frames, count, (uint64_t)milliseconds * 1000, sent);
+}
+
+bool candle_send_frames_us(struct candle_device *device, uint8_t channel, struct candle_can_frame *frames, size_t count, uint64_t microseconds, size_t *sent) {
+    struct candle_device_handle *handle = device->handle;
+
+    uint64_t deadline_ns = deadline_after_us(microseconds);
+
+    *sent = 0;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    if (!handle->channels[channel].is_start)
+        return false;
+
+    if (count == 0)
+        return false;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (frames[i].can_dlc >= ARRAY_SIZE(dlc2len))
+            return false;
+
+        if (frames[i].type & CANDLE_FRAME_TYPE_FD && !(device->channels[channel].feature & CANDLE_FEATURE_FD))
+            return false;
+    }
+
+    // queue the whole burst, it is sent in arbitration order
+    if (handle->channels[channel].tx_queue != NULL) {
+        while (*sent < count && tx_queue_put(handle, channel, &frames[*sent], deadline_ns, 0))
+            (*sent)++;
+        return *sent > 0;
+    }
+
+    // reserve as many echo ids as possible, wait if none is available
+    uint32_t reserved;
+    wakeup_lock(&handle->channels[channel].echo_id_wakeup);
+    while ((reserved = id_pool_acquire_many(&handle->channels[channel].echo_id_pool, count)) == 0) {
+        if (wait_for_wakeup(&handle->channels[channel].echo_id_wakeup, deadline_ns) != thrd_success) {
+            wakeup_unlock(&handle->channels[channel].echo_id_wakeup);
+            return false;
         }
     }
+    wakeup_unlock(&handle->channels[channel].echo_id_wakeup);
+
+    // submit the burst
+    for (uint32_t echo_id = 0; echo_id < 32; ++echo_id) {
+        if (!(reserved & (1u << echo_id)))
+            continue;
 
-    return send_frame(handle, channel, frame, echo_id);
+        // release remaining echo ids on failure (send_frame released the current one)
+        if (!send_frame(handle, channel, &frames[*sent], echo_id, 0)) {
+            id_pool_release_many(&handle->channels[channel].echo_id_pool, reserved & ~((2u << echo_id) - 1));
+            wakeup_broadcast(&handle->channels[channel].echo_id_wakeup);
+            break;
+        }
+        (*sent)++;
+    }
+
+    return *sent > 0;
 }
 
 bool candle_receive_frame_nowait(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame) {
@@ -1024,60 +1941,385 @@ bool candle_receive_frame_nowait(struct candle_device *device, uint8_t channel,
     if (channel >= device->channel_count)
         return false;
 
-    if (!handle->channels[channel].is_start)
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (!rx_reader_enter(ch))
         return false;
 
-    struct gs_host_frame *hf = alloca(handle->rx_size);
+    bool r = rx_queue_get(ch, frame);
+    rx_reader_leave(ch);
+    return r;
+}
+
+bool candle_receive_frame(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint32_t milliseconds) {
+    return candle_receive_frame_us(device, channel, frame, (uint64_t)milliseconds * 1000);
+}
+
+static bool receive_frame(struct candle_device_handle *handle, struct candle_channel_handle *ch, struct candle_can_frame *frame, uint64_t microseconds) {
+    // fast path
+    if (rx_queue_get(ch, frame))
+        return true;
+
+    // spin before paying for a sleep and wake-up, both within the one timeout
+    uint64_t deadline_ns = deadline_after_us(microseconds);
+    uint64_t end_ns = busy_poll_end(handle, deadline_ns);
+    while (end_ns != 0 && busy_poll_step(end_ns)) {
+        if (rx_queue_get(ch, frame))
+            return true;
+    }
+
+    // register as waiter and check again (the producer only signals registered waiters)
+    wakeup_lock(&ch->rx_wakeup);
+    bool r = rx_queue_get(ch, frame);
+    if (!r) {
+        while (!r && atomic_load(&ch->is_start) && wait_for_wakeup(&ch->rx_wakeup, deadline_ns) == thrd_success)
+            r = rx_queue_get(ch, frame);
+    }
+    wakeup_unlock(&ch->rx_wakeup);
+
+    return r;
+}
+
+bool candle_receive_frame_us(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint64_t microseconds) {
+    struct candle_device_handle *handle = device->handle;
 
-    if (fifo_get(handle->channels[channel].rx_fifo, hf) < 0)
+    if (channel >= device->channel_count)
         return false;
 
-    convert_frame(hf, frame, handle->channels[channel].mode & CANDLE_MODE_HW_TIMESTAMP);
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (!rx_reader_enter(ch))
+        return false;
 
-    return true;
+    bool r = receive_frame(handle, ch, frame, microseconds);
+    rx_reader_leave(ch);
+    return r;
 }
 
-bool candle_receive_frame(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint32_t milliseconds) {
+bool candle_receive_frames(struct candle_device *device, uint8_t channel, struct candle_can_frame *frames, size_t max_count, uint32_t milliseconds, size_t *count) {
+    return candle_receive_frames_us(device, channel, frames, max_count, (uint64_t)milliseconds * 1000, count);
+}
+
+static bool receive_frames(struct candle_device_handle *handle, struct candle_channel_handle *ch, struct candle_can_frame *frames, size_t max_count, uint64_t microseconds, size_t *count) {
+    // spin before paying for a sleep and wake-up, both within the one timeout
+    uint64_t deadline_ns = deadline_after_us(microseconds);
+    uint64_t end_ns = busy_poll_end(handle, deadline_ns);
+    while (end_ns != 0 && rx_queue_is_empty(ch) && busy_poll_step(end_ns));
+
+    // wait for the first frame
+    if (rx_queue_is_empty(ch)) {
+        wakeup_lock(&ch->rx_wakeup);
+        bool r = !rx_queue_is_empty(ch);
+        if (!r) {
+            while (!r && atomic_load(&ch->is_start) && wait_for_wakeup(&ch->rx_wakeup, deadline_ns) == thrd_success)
+                r = !rx_queue_is_empty(ch);
+        }
+        wakeup_unlock(&ch->rx_wakeup);
+        if (!r)
+            return false;
+    }
+
+    // drain as many frames as possible
+    if (ch->rx_ring != NULL) {
+        // at most two contiguous spans (before and after the wrap)
+        const struct candle_can_frame *span;
+        size_t n;
+        while (*count < max_count && (span = spsc_read_span(ch->rx_ring, &n)) != NULL) {
+            n = min(n, max_count - *count);
+            memcpy(&frames[*count], span, n * sizeof(struct candle_can_frame));
+            spsc_read_commit(ch->rx_ring, n);
+            *count += n;
+        }
+    } else {
+        // under a single lock
+        MUTEX_LOCK(ch->rx_fifo->mutex);
+        while (*count < max_count && fifo_get_noprotect(ch->rx_fifo, &frames[*count]) == 0)
+            (*count)++;
+        MUTEX_UNLOCK(ch->rx_fifo->mutex);
+    }
+
+    return *count > 0;
+}
+
+bool candle_receive_frames_us(struct candle_device *device, uint8_t channel, struct candle_can_frame *frames, size_t max_count, uint64_t microseconds, size_t *count) {
     struct candle_device_handle *handle = device->handle;
 
+    *count = 0;
+
     if (channel >= device->channel_count)
         return false;
 
-    if (!handle->channels[channel].is_start)
+    if (max_count == 0)
         return false;
 
-    struct gs_host_frame *hf = alloca(handle->rx_size);
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (!rx_reader_enter(ch))
+        return false;
+
+    bool r = receive_frames(handle, ch, frames, max_count, microseconds, count);
+    rx_reader_leave(ch);
+    return r;
+}
 
-    MUTEX_LOCK(handle->channels[channel].rx_fifo->mutex);
-    bool empty = fifo_get_noprotect(handle->channels[channel].rx_fifo, hf) < 0;
-    if (empty)
-        mtx_lock(&handle->channels[channel].rx_cond_mtx);
-    MUTEX_UNLOCK(handle->channels[channel].rx_fifo->mutex);
+bool candle_get_event_fd(struct candle_device *device, int *fd) {
+    struct candle_device_handle *handle = device->handle;
 
-    if (!empty) {
-        convert_frame(hf, frame, handle->channels[channel].mode & CANDLE_MODE_HW_TIMESTAMP);
-        return true;
+    // created on first use by exactly one caller, lives as long as the device
+    int state = EVENT_FD_CLOSED;
+    if (atomic_compare_exchange_strong(&handle->event_fd_state, &state, EVENT_FD_OPENING)) {
+        if (!event_fd_open(&handle->event_fd)) {
+            atomic_store(&handle->event_fd_state, EVENT_FD_CLOSED);
+            return false;
+        }
+        atomic_store(&handle->event_fd_state, EVENT_FD_OPEN);
+
+        // frames queued before the descriptor existed did not notify it
+        for (uint8_t i = 0; i < device->channel_count; ++i) {
+            if (handle->channels[i].is_start && rx_queue_used(&handle->channels[i]) > 0) {
+                event_fd_notify(&handle->event_fd);
+                break;
+            }
+        }
+    } else {
+        // another caller is opening it
+        while (state == EVENT_FD_OPENING) {
+            thrd_yield();
+            state = atomic_load(&handle->event_fd_state);
+        }
+        if (state != EVENT_FD_OPEN)
+            return false;
     }
 
-    struct timespec ts;
-    milliseconds_to_timespec(milliseconds, &ts);
+    *fd = handle->event_fd.read_fd;
+    return true;
+}
+
+void candle_reset_event_fd(struct candle_device *device) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (atomic_load(&handle->event_fd_state) == EVENT_FD_OPEN)
+        event_fd_reset(&handle->event_fd);
+}
+
+bool candle_peek_frames(struct candle_device *device, uint8_t channel, const struct candle_can_frame **frames, size_t *count) {
+    struct candle_device_handle *handle = device->handle;
+
+    *count = 0;
 
-    bool r = cnd_timedwait(&handle->channels[channel].rx_cnd, &handle->channels[channel].rx_cond_mtx, &ts) == thrd_success;
-    if (r) r = fifo_get(handle->channels[channel].rx_fifo, hf) == 0;
-    mtx_unlock(&handle->channels[channel].rx_cond_mtx);
+    if (channel >= device->channel_count)
+        return false;
+
+    // only the lock-free queue leaves queued frames alone
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->rx_ring == NULL || !rx_reader_enter(ch))
+        return false;
+
+    *frames = spsc_read_span(ch->rx_ring, count);
+    ch->rx_peeked = *count;
+    rx_reader_leave(ch);
+    return *count > 0;
+}
 
-    if (r) convert_frame(hf, frame, handle->channels[channel].mode & CANDLE_MODE_HW_TIMESTAMP);
+bool candle_commit_frames(struct candle_device *device, uint8_t channel, size_t count) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    // a reset or close in between dropped the peeked frames
+    struct candle_channel_handle *ch = &handle->channels[channel];
+    if (ch->rx_ring == NULL || !rx_reader_enter(ch))
+        return false;
+
+    bool r = count <= ch->rx_peeked;
+    if (r) {
+        spsc_read_commit(ch->rx_ring, count);
+        ch->rx_peeked -= count;
+    }
+    rx_reader_leave(ch);
     return r;
 }
 
+static uint32_t ready_channels(struct candle_device_handle *handle, size_t *depths) {
+    uint32_t ready = 0;
+
+    // one lock-free pass, channels beyond 32 are only reported through depths
+    for (uint8_t i = 0; i < handle->device->channel_count; ++i) {
+        size_t used = handle->channels[i].is_start ? rx_queue_used(&handle->channels[i]) : 0;
+        if (depths != NULL)
+            depths[i] = used;
+        if (used > 0 && i < 32)
+            ready |= 1u << i;
+    }
+    return ready;
+}
+
+bool candle_wait_for_channels(struct candle_device *device, uint32_t milliseconds, uint32_t *ready, size_t *depths) {
+    return candle_wait_for_channels_us(device, (uint64_t)milliseconds * 1000, ready, depths);
+}
+
+bool candle_wait_for_channels_us(struct candle_device *device, uint64_t microseconds, uint32_t *ready, size_t *depths) {
+    struct candle_device_handle *handle = device->handle;
+
+    // fast path
+    *ready = ready_channels(handle, depths);
+    if (*ready)
+        return true;
+
+    // spin before paying for a sleep and wake-up, both within the one timeout
+    uint64_t deadline_ns = deadline_after_us(microseconds);
+    uint64_t end_ns = busy_poll_end(handle, deadline_ns);
+    while (end_ns != 0 && busy_poll_step(end_ns)) {
+        *ready = ready_channels(handle, depths);
+        if (*ready)
+            return true;
+    }
+
+    // register as waiter and check again (the producer only signals registered waiters)
+    wakeup_lock(&handle->rx_wakeup);
+    *ready = ready_channels(handle, depths);
+    if (!*ready) {
+        while (!*ready && wait_for_wakeup(&handle->rx_wakeup, deadline_ns) == thrd_success)
+            *ready = ready_channels(handle, depths);
+    }
+    wakeup_unlock(&handle->rx_wakeup);
+
+    return *ready != 0;
+}
+
 bool candle_wait_for_frame(struct candle_device *device, uint32_t milliseconds) {
+    return candle_wait_for_frame_us(device, (uint64_t)milliseconds * 1000);
+}
+
+bool candle_wait_for_frame_us(struct candle_device *device, uint64_t microseconds) {
     struct candle_device_handle *handle = device->handle;
 
-    struct timespec ts;
-    milliseconds_to_timespec(milliseconds, &ts);
+    uint64_t deadline_ns = deadline_after_us(microseconds);
+
+    wakeup_lock(&handle->rx_wakeup);
+    bool r = wait_for_wakeup(&handle->rx_wakeup, deadline_ns) == thrd_success;
 
-    mtx_lock(&handle->rx_cond_mtx);
-    bool r = cnd_timedwait(&handle->rx_cnd, &handle->rx_cond_mtx, &ts) == thrd_success;
-    mtx_unlock(&handle->rx_cond_mtx);
+    // handling events may return before anything was received
+    while (app_driven && r && ready_channels(handle, NULL) == 0)
+        r = wait_for_wakeup(&handle->rx_wakeup, deadline_ns) == thrd_success;
+    wakeup_unlock(&handle->rx_wakeup);
     return r;
-}
\ No newline at end of file
+}
+
+static bool cyclic_send(void *context, uint8_t channel, struct candle_can_frame *frame, uint64_t deadline_ns) {
+    struct candle_device_handle *handle = context;
+    return send_frame_nowait(handle->device, channel, frame, deadline_ns);
+}
+
+static cyclic_t *get_cyclic(struct candle_device_handle *handle) {
+    cyclic_t *cyclic = atomic_load(&handle->cyclic);
+    if (cyclic != NULL)
+        return cyclic;
+
+    // first use, another thread may be creating one at the same time
+    cyclic_t *created = cyclic_create(cyclic_send, handle);
+    if (created == NULL)
+        return NULL;
+    if (!atomic_compare_exchange_strong(&handle->cyclic, &cyclic, created)) {
+        cyclic_destroy(created);
+        return cyclic;
+    }
+    return created;
+}
+
+bool candle_add_cyclic_frame(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint32_t period_us, uint32_t *id) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    if (!device->is_open)
+        return false;
+
+    if (period_us == 0)
+        return false;
+
+    if (frame->can_dlc >= ARRAY_SIZE(dlc2len))
+        return false;
+
+    if (frame->type & CANDLE_FRAME_TYPE_FD && !(device->channels[channel].feature & CANDLE_FEATURE_FD))
+        return false;
+
+    cyclic_t *cyclic = get_cyclic(handle);
+    if (cyclic == NULL)
+        return false;
+
+    return cyclic_add(cyclic, channel, frame, (uint64_t)period_us * 1000u, id);
+}
+
+bool candle_update_cyclic_frame(struct candle_device *device, uint32_t id, struct candle_can_frame *frame, uint32_t period_us) {
+    cyclic_t *cyclic = atomic_load(&device->handle->cyclic);
+
+    if (cyclic == NULL)
+        return false;
+
+    if (period_us == 0)
+        return false;
+
+    if (frame->can_dlc >= ARRAY_SIZE(dlc2len))
+        return false;
+
+    return cyclic_update(cyclic, id, frame, (uint64_t)period_us * 1000u);
+}
+
+bool candle_remove_cyclic_frame(struct candle_device *device, uint32_t id) {
+    cyclic_t *cyclic = atomic_load(&device->handle->cyclic);
+
+    if (cyclic == NULL)
+        return false;
+
+    return cyclic_remove(cyclic, id);
+}
+
+bool candle_get_cyclic_stats(struct candle_device *device, uint32_t id, struct candle_cyclic_stats *stats) {
+    cyclic_t *cyclic = atomic_load(&device->handle->cyclic);
+
+    if (cyclic == NULL)
+        return false;
+
+    return cyclic_get_stats(cyclic, id, stats);
+}
+
+bool candle_send_frame_at(struct candle_device *device, uint8_t channel, struct candle_can_frame *frame, uint64_t monotonic_ns) {
+    struct candle_device_handle *handle = device->handle;
+
+    if (channel >= device->channel_count)
+        return false;
+
+    if (!handle->channels[channel].is_start)
+        return false;
+
+    if (monotonic_ns == 0)
+        return false;
+
+    if (frame->can_dlc >= ARRAY_SIZE(dlc2len))
+        return false;
+
+    if (frame->type & CANDLE_FRAME_TYPE_FD && !(device->channels[channel].feature & CANDLE_FEATURE_FD))
+        return false;
+
+    cyclic_t *cyclic = get_cyclic(handle);
+    if (cyclic == NULL)
+        return false;
+
+    return cyclic_add_once(cyclic, channel, frame, monotonic_ns);
+}
+
+bool candle_set_tx_schedule_spin(struct candle_device *device, uint32_t microseconds) {
+    if (!device->is_open)
+        return false;
+
+    cyclic_t *cyclic = get_cyclic(device->handle);
+    if (cyclic == NULL)
+        return false;
+
+    cyclic_set_spin(cyclic, (uint64_t)microseconds * 1000u);
+    return true;
+}
+
+uint64_t candle_monotonic_ns(void) {
+    return clock_monotonic_ns();
+}
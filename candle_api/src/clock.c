@@ -0,0 +1,109 @@
+#include "clock.h"
+#include <float.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define CLOCK_SYNC_WINDOW_US 1000000            // one offset sample per second of device time
+#define CLOCK_SYNC_DECAY 0.98                   // weight kept by older samples (time constant ~50 s)
+#define CLOCK_SYNC_MAX_GAP_NS 1800000000000ull  // after a longer silence the old fit is stale, start over
+
+uint64_t clock_monotonic_ns(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000u +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000u / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void clock_unwrap_reset(clock_unwrap_t *u) {
+    u->valid = false;
+    u->value = 0;
+}
+
+uint64_t clock_unwrap(clock_unwrap_t *u, uint32_t counter, uint64_t host_ns) {
+    if (!u->valid) {
+        u->value = counter;
+        u->last_host_ns = host_ns;
+        u->valid = true;
+        return u->value;
+    }
+
+    // only moves forward, add the whole wraps that bring the step closest to the host elapsed time
+    uint64_t delta = (uint32_t)(counter - (uint32_t)u->value);
+    uint64_t elapsed_us = (host_ns - u->last_host_ns) / 1000;
+    if (elapsed_us > delta)
+        delta += (elapsed_us - delta + (1ull << 31)) >> 32 << 32;
+
+    u->value += delta;
+    u->last_host_ns = host_ns;
+    return u->value;
+}
+
+void clock_sync_reset(clock_sync_t *cs) {
+    clock_unwrap_reset(&cs->device);
+    cs->valid = false;
+}
+
+uint64_t clock_sync_update(clock_sync_t *cs, uint32_t device_us, uint64_t host_ns) {
+    if (cs->valid && host_ns - cs->last_host_ns > CLOCK_SYNC_MAX_GAP_NS)
+        clock_sync_reset(cs);
+    cs->last_host_ns = host_ns;
+
+    uint64_t device = clock_unwrap(&cs->device, device_us, host_ns);
+    if (!cs->valid) {
+        cs->valid = true;
+        cs->base_device_us = device;
+        cs->base_host_ns = host_ns;
+        cs->window_start_us = device;
+        cs->window_x = 0;
+        cs->window_y = DBL_MAX;
+        cs->sw = cs->sx = cs->sy = cs->sxx = cs->sxy = 0;
+        cs->offset_ns = 0;
+        cs->drift = 0;
+    }
+
+    // x: device time since base (us), y: host time minus device time (ns)
+    double x = (double)(int64_t)(device - cs->base_device_us);
+    double y = (double)(int64_t)(host_ns - cs->base_host_ns) - x * 1000.0;
+
+    if (y < cs->window_y) {
+        cs->window_x = x;
+        cs->window_y = y;
+    }
+
+    if (cs->sw == 0) {
+        // nothing fitted yet, follow the lowest offset seen so far
+        cs->offset_ns = cs->window_y - cs->drift * cs->window_x;
+    }
+
+    if ((int64_t)(device - cs->window_start_us) >= CLOCK_SYNC_WINDOW_US) {
+        cs->sw = cs->sw * CLOCK_SYNC_DECAY + 1;
+        cs->sx = cs->sx * CLOCK_SYNC_DECAY + cs->window_x;
+        cs->sy = cs->sy * CLOCK_SYNC_DECAY + cs->window_y;
+        cs->sxx = cs->sxx * CLOCK_SYNC_DECAY + cs->window_x * cs->window_x;
+        cs->sxy = cs->sxy * CLOCK_SYNC_DECAY + cs->window_x * cs->window_y;
+
+        double denominator = cs->sw * cs->sxx - cs->sx * cs->sx;
+        if (cs->sw > 1.5 && denominator > 0)
+            cs->drift = (cs->sw * cs->sxy - cs->sx * cs->sy) / denominator;
+        cs->offset_ns = (cs->sy - cs->drift * cs->sx) / cs->sw;
+
+        cs->window_start_us = device;
+        cs->window_y = DBL_MAX;
+    }
+
+    double mapped = x * 1000.0 + cs->offset_ns + cs->drift * x;
+    return cs->base_host_ns + (uint64_t)(int64_t)mapped;
+}
@@ -0,0 +1,42 @@
+#ifndef CANDLE_API_CLOCK_H
+#define CANDLE_API_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Host monotonic clock (CLOCK_MONOTONIC, QueryPerformanceCounter on Windows).
+uint64_t clock_monotonic_ns(void);
+
+// Extends a wrapping 32 bit microsecond counter to 64 bit. Samples must arrive in order; the host
+// time since the previous sample tells how many whole wraps passed while nothing was received.
+typedef struct {
+    bool valid;
+    uint64_t value;
+    uint64_t last_host_ns;
+} clock_unwrap_t;
+
+void clock_unwrap_reset(clock_unwrap_t *u);
+uint64_t clock_unwrap(clock_unwrap_t *u, uint32_t counter, uint64_t host_ns);
+
+// Maps a device microsecond counter to host monotonic time.
+// Every sample pairs a device timestamp with the host time its transfer completed. The sample
+// with the smallest offset (least delayed completion) of each window feeds an exponentially
+// weighted linear fit of offset over device time, which gives the offset and the drift.
+typedef struct {
+    clock_unwrap_t device;
+    bool valid;
+    uint64_t base_device_us;
+    uint64_t base_host_ns;
+    uint64_t last_host_ns;
+    uint64_t window_start_us;
+    double window_x;
+    double window_y;
+    double sw, sx, sy, sxx, sxy;
+    double offset_ns;
+    double drift;       // ns per us of device time
+} clock_sync_t;
+
+void clock_sync_reset(clock_sync_t *cs);
+uint64_t clock_sync_update(clock_sync_t *cs, uint32_t device_us, uint64_t host_ns);
+
+#endif // CANDLE_API_CLOCK_H
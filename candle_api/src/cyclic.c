@@ -0,0 +1,300 @@
+#include "cyclic.h"
+#include "clock.h"
+#include <stdlib.h>
+#include <string.h>
+
+static inline bool entry_before(const struct cyclic_entry *a, const struct cyclic_entry *b) {
+    if (a->deadline_ns != b->deadline_ns)
+        return a->deadline_ns < b->deadline_ns;
+    return a->seq < b->seq;
+}
+
+static inline bool heap_before(cyclic_t *c, size_t i, size_t j) {
+    return entry_before(&c->entries[c->heap[i]], &c->entries[c->heap[j]]);
+}
+
+static inline void heap_set(cyclic_t *c, size_t i, uint32_t id) {
+    c->heap[i] = id;
+    c->entries[id].heap_index = i;
+}
+
+static void sift_up(cyclic_t *c, size_t i) {
+    uint32_t id = c->heap[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!entry_before(&c->entries[id], &c->entries[c->heap[parent]]))
+            break;
+        heap_set(c, i, c->heap[parent]);
+        i = parent;
+    }
+    heap_set(c, i, id);
+}
+
+static void sift_down(cyclic_t *c, size_t i) {
+    uint32_t id = c->heap[i];
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= c->heap_size)
+            break;
+        if (child + 1 < c->heap_size && heap_before(c, child + 1, child))
+            child++;
+        if (!entry_before(&c->entries[c->heap[child]], &c->entries[id]))
+            break;
+        heap_set(c, i, c->heap[child]);
+        i = child;
+    }
+    heap_set(c, i, id);
+}
+
+static void heap_remove(cyclic_t *c, size_t i) {
+    // fill the hole with the last node
+    c->heap_size--;
+    if (i != c->heap_size) {
+        uint32_t moved = c->heap[c->heap_size];
+        heap_set(c, i, moved);
+        sift_up(c, i);
+        sift_down(c, c->entries[moved].heap_index);
+    }
+}
+
+static void free_entry(cyclic_t *c, uint32_t id) {
+    c->entries[id].used = false;
+    c->entries[id].heap_index = c->free_head;
+    c->free_head = id;
+}
+
+// submit the earliest frame and schedule its next cycle
+static void fire(cyclic_t *c) {
+    uint32_t id = c->heap[0];
+    struct cyclic_entry *e = &c->entries[id];
+    uint64_t now = clock_monotonic_ns();
+    uint64_t lateness = now - e->deadline_ns;
+
+    if (c->send(c->context, e->channel, &e->frame, e->deadline_ns))
+        e->stats.sent++;
+    else
+        e->stats.send_errors++;
+
+    if (e->stats.sent + e->stats.send_errors == 1 || lateness < e->stats.jitter_min_ns)
+        e->stats.jitter_min_ns = lateness;
+    if (lateness > e->stats.jitter_max_ns)
+        e->stats.jitter_max_ns = lateness;
+    e->stats.jitter_sum_ns += lateness;
+
+    if (e->period_ns == 0) {
+        heap_remove(c, 0);
+        free_entry(c, id);
+        return;
+    }
+
+    // stay on the original phase, skip the cycles that are already over
+    e->deadline_ns += e->period_ns;
+    if (e->deadline_ns <= now) {
+        uint64_t missed = (now - e->deadline_ns) / e->period_ns + 1;
+        e->stats.missed += missed;
+        e->deadline_ns += missed * e->period_ns;
+    }
+    e->seq = c->seq++;
+    sift_down(c, 0);
+}
+
+static int cyclic_thread_func(void *arg) {
+    cyclic_t *c = arg;
+
+    mono_cond_lock(&c->cond);
+    while (c->run) {
+        if (c->heap_size == 0) {
+            mono_cond_wait(&c->cond);
+            continue;
+        }
+
+        uint64_t deadline = c->entries[c->heap[0]].deadline_ns;
+        uint64_t now = clock_monotonic_ns();
+        if (now >= deadline) {
+            fire(c);
+            continue;
+        }
+
+        if (deadline - now <= c->spin_ns) {
+            // close enough, busy-wait without the lock so the frames can still be changed
+            mono_cond_unlock(&c->cond);
+            while (clock_monotonic_ns() < deadline)
+                cpu_relax();
+            mono_cond_lock(&c->cond);
+            continue;
+        }
+
+        // sleeps on the monotonic clock, woken early by a change re-evaluates the earliest deadline
+        mono_cond_wait_until(&c->cond, deadline - c->spin_ns);
+    }
+    mono_cond_unlock(&c->cond);
+    return 0;
+}
+
+cyclic_t *cyclic_create(cyclic_send_fn send, void *context) {
+    cyclic_t *c = malloc(sizeof(cyclic_t));
+    if (c == NULL)
+        return NULL;
+
+    c->run = true;
+    c->send = send;
+    c->context = context;
+    c->spin_ns = 0;
+    c->seq = 0;
+    c->entries = NULL;
+    c->capacity = 0;
+    c->free_head = CYCLIC_NO_ID;
+    c->heap = NULL;
+    c->heap_size = 0;
+    mono_cond_init(&c->cond);
+
+    if (thrd_create(&c->thread, cyclic_thread_func, c) != thrd_success) {
+        mono_cond_destroy(&c->cond);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+void cyclic_destroy(cyclic_t *c) {
+    if (c == NULL)
+        return;
+
+    mono_cond_lock(&c->cond);
+    c->run = false;
+    mono_cond_signal(&c->cond);
+    mono_cond_unlock(&c->cond);
+    thrd_join(c->thread, NULL);
+
+    mono_cond_destroy(&c->cond);
+    free(c->entries);
+    free(c->heap);
+    free(c);
+}
+
+void cyclic_set_spin(cyclic_t *c, uint64_t spin_ns) {
+    mono_cond_lock(&c->cond);
+    c->spin_ns = spin_ns;
+    mono_cond_signal(&c->cond);
+    mono_cond_unlock(&c->cond);
+}
+
+static bool grow(cyclic_t *c) {
+    size_t capacity = c->capacity == 0 ? 16 : c->capacity * 2;
+    if (capacity >= CYCLIC_NO_ID)
+        return false;
+
+    struct cyclic_entry *entries = realloc(c->entries, capacity * sizeof(struct cyclic_entry));
+    if (entries == NULL)
+        return false;
+    c->entries = entries;
+
+    uint32_t *heap = realloc(c->heap, capacity * sizeof(uint32_t));
+    if (heap == NULL)
+        return false;
+    c->heap = heap;
+
+    for (size_t i = capacity; i > c->capacity; --i)
+        free_entry(c, (uint32_t)(i - 1));
+    c->capacity = capacity;
+    return true;
+}
+
+static bool add(cyclic_t *c, uint8_t channel, const struct candle_can_frame *frame, uint64_t period_ns, uint64_t deadline_ns, uint32_t *id) {
+    if (c->free_head == CYCLIC_NO_ID && !grow(c))
+        return false;
+
+    uint32_t i = (uint32_t)c->free_head;
+    struct cyclic_entry *e = &c->entries[i];
+    c->free_head = e->heap_index;
+
+    memset(e, 0, sizeof(struct cyclic_entry));
+    e->used = true;
+    e->channel = channel;
+    e->frame = *frame;
+    e->period_ns = period_ns;
+    e->deadline_ns = deadline_ns;
+    e->seq = c->seq++;
+
+    c->heap[c->heap_size] = i;
+    sift_up(c, c->heap_size++);
+
+    // the thread may sleep towards a later deadline
+    if (c->heap[0] == i)
+        mono_cond_signal(&c->cond);
+
+    if (id != NULL)
+        *id = i;
+    return true;
+}
+
+bool cyclic_add(cyclic_t *c, uint8_t channel, const struct candle_can_frame *frame, uint64_t period_ns, uint32_t *id) {
+    mono_cond_lock(&c->cond);
+    // first frame goes out right away
+    bool r = add(c, channel, frame, period_ns, clock_monotonic_ns(), id);
+    mono_cond_unlock(&c->cond);
+    return r;
+}
+
+bool cyclic_add_once(cyclic_t *c, uint8_t channel, const struct candle_can_frame *frame, uint64_t deadline_ns) {
+    mono_cond_lock(&c->cond);
+    bool r = add(c, channel, frame, 0, deadline_ns, NULL);
+    mono_cond_unlock(&c->cond);
+    return r;
+}
+
+static struct cyclic_entry *find_periodic(cyclic_t *c, uint32_t id) {
+    if (id >= c->capacity || !c->entries[id].used || c->entries[id].period_ns == 0)
+        return NULL;
+    return &c->entries[id];
+}
+
+bool cyclic_update(cyclic_t *c, uint32_t id, const struct candle_can_frame *frame, uint64_t period_ns) {
+    mono_cond_lock(&c->cond);
+    struct cyclic_entry *e = find_periodic(c, id);
+    if (e == NULL) {
+        mono_cond_unlock(&c->cond);
+        return false;
+    }
+
+    // the new content goes out at the next deadline
+    e->frame = *frame;
+    if (period_ns != e->period_ns) {
+        // next deadline counts from the previous one with the new period
+        e->deadline_ns = e->deadline_ns - e->period_ns + period_ns;
+        e->period_ns = period_ns;
+        sift_up(c, e->heap_index);
+        sift_down(c, e->heap_index);
+        mono_cond_signal(&c->cond);
+    }
+
+    mono_cond_unlock(&c->cond);
+    return true;
+}
+
+bool cyclic_remove(cyclic_t *c, uint32_t id) {
+    mono_cond_lock(&c->cond);
+    struct cyclic_entry *e = find_periodic(c, id);
+    if (e == NULL) {
+        mono_cond_unlock(&c->cond);
+        return false;
+    }
+
+    heap_remove(c, e->heap_index);
+    free_entry(c, id);
+    mono_cond_unlock(&c->cond);
+    return true;
+}
+
+bool cyclic_get_stats(cyclic_t *c, uint32_t id, struct candle_cyclic_stats *stats) {
+    mono_cond_lock(&c->cond);
+    struct cyclic_entry *e = find_periodic(c, id);
+    if (e == NULL) {
+        mono_cond_unlock(&c->cond);
+        return false;
+    }
+
+    *stats = e->stats;
+    mono_cond_unlock(&c->cond);
+    return true;
+}
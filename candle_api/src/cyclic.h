@@ -0,0 +1,55 @@
+#ifndef CANDLE_API_CYCLIC_H
+#define CANDLE_API_CYCLIC_H
+
+#include "candle_api.h"
+#include "compiler.h"
+#include "mono_cond.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Transmit scheduler for periodic and one-shot frames.
+// One thread keeps the frames in a min-heap ordered by their absolute monotonic deadline (equal
+// deadlines in insertion order) and submits each one when it is due. The next deadline of a periodic
+// frame is derived from the previous one, not from the submit time, so lateness does not accumulate.
+// Cycles that are more than a period late are skipped and counted instead of sent in a burst.
+// With a spin time set the thread wakes up that much early and busy-waits for the deadline.
+typedef bool (*cyclic_send_fn)(void *context, uint8_t channel, struct candle_can_frame *frame, uint64_t deadline_ns);
+
+#define CYCLIC_NO_ID UINT32_MAX
+
+struct cyclic_entry {
+    bool used;
+    uint8_t channel;
+    struct candle_can_frame frame;
+    uint64_t period_ns;     // 0 for one-shot frames
+    uint64_t deadline_ns;
+    uint64_t seq;
+    size_t heap_index;      // next free id while unused
+    struct candle_cyclic_stats stats;
+};
+
+typedef struct {
+    thrd_t thread;
+    mono_cond_t cond;
+    bool run;
+    cyclic_send_fn send;
+    void *context;
+    uint64_t spin_ns;
+    uint64_t seq;
+    struct cyclic_entry *entries;   // indexed by id
+    size_t capacity;
+    size_t free_head;               // first unused id, CYCLIC_NO_ID if none
+    uint32_t *heap;                 // entry ids, earliest deadline first
+    size_t heap_size;
+} cyclic_t;
+
+cyclic_t *cyclic_create(cyclic_send_fn send, void *context);
+void cyclic_destroy(cyclic_t *c);
+void cyclic_set_spin(cyclic_t *c, uint64_t spin_ns);
+bool cyclic_add(cyclic_t *c, uint8_t channel, const struct candle_can_frame *frame, uint64_t period_ns, uint32_t *id);
+bool cyclic_add_once(cyclic_t *c, uint8_t channel, const struct candle_can_frame *frame, uint64_t deadline_ns);
+bool cyclic_update(cyclic_t *c, uint32_t id, const struct candle_can_frame *frame, uint64_t period_ns);
+bool cyclic_remove(cyclic_t *c, uint32_t id);
+bool cyclic_get_stats(cyclic_t *c, uint32_t id, struct candle_cyclic_stats *stats);
+
+#endif // CANDLE_API_CYCLIC_H
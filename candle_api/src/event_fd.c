@@ -0,0 +1,68 @@
+#include "event_fd.h"
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool event_fd_open(event_fd_t *e) {
+    atomic_init(&e->pending, false);
+#if defined(__linux__)
+    e->read_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    e->write_fd = e->read_fd;
+    return e->read_fd >= 0;
+#elif !defined(_WIN32)
+    int fds[2];
+    if (pipe(fds) != 0) {
+        e->read_fd = e->write_fd = -1;
+        return false;
+    }
+    for (int i = 0; i < 2; ++i) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    e->read_fd = fds[0];
+    e->write_fd = fds[1];
+    return true;
+#else
+    e->read_fd = e->write_fd = -1;
+    return false;
+#endif
+}
+
+void event_fd_close(event_fd_t *e) {
+#if !defined(_WIN32)
+    if (e->write_fd >= 0 && e->write_fd != e->read_fd)
+        close(e->write_fd);
+    if (e->read_fd >= 0)
+        close(e->read_fd);
+#endif
+    e->read_fd = e->write_fd = -1;
+}
+
+void event_fd_notify(event_fd_t *e) {
+    // pairs with the store in event_fd_reset: either the owner sees the frame or we see the reset
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&e->pending, memory_order_relaxed) || atomic_exchange(&e->pending, true))
+        return;
+
+#if !defined(_WIN32)
+    uint64_t one = 1;
+    ssize_t rc = write(e->write_fd, &one, sizeof(one));
+    (void)rc;   // full pipe is still readable
+#endif
+}
+
+void event_fd_reset(event_fd_t *e) {
+#if !defined(_WIN32)
+    uint64_t buf[8];
+    while (read(e->read_fd, buf, sizeof(buf)) > 0);
+#endif
+
+    // the next queued frame makes the descriptor readable again
+    atomic_store(&e->pending, false);
+}
@@ -0,0 +1,23 @@
+#ifndef CANDLE_API_EVENT_FD_H
+#define CANDLE_API_EVENT_FD_H
+
+#include "compiler.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// File descriptor that becomes readable when the event thread queues a frame.
+// An eventfd on Linux, a non-blocking pipe on other POSIX systems, not available on Windows.
+// The notifier only writes while the descriptor is not already readable, so a burst of
+// frames costs a single syscall. The owner calls event_fd_reset before draining the queues.
+typedef struct {
+    int read_fd;
+    int write_fd;
+    atomic_bool pending;
+} event_fd_t;
+
+bool event_fd_open(event_fd_t *e);
+void event_fd_close(event_fd_t *e);
+void event_fd_notify(event_fd_t *e);
+void event_fd_reset(event_fd_t *e);
+
+#endif // CANDLE_API_EVENT_FD_H
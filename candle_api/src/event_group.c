@@ -0,0 +1,117 @@
+#include "event_group.h"
+#include "thread_policy.h"
+#include "clock.h"
+#include <stdlib.h>
+
+static LIST_HEAD(event_groups);
+
+static int event_thread_func(void *arg) {
+    event_group_t *g = arg;
+
+    // report back before handling any event, the opener fails if the scheduling is refused
+    bool ok = thread_set_affinity(g->cpu) && thread_set_priority(g->priority);
+    atomic_store(&g->state, ok ? 1 : -1);
+
+    while (ok && atomic_load_explicit(&g->run, memory_order_relaxed)) {
+        libusb_handle_events(g->ctx);
+        if (g->busy_poll_ns == 0) {
+            thrd_yield();
+            continue;
+        }
+
+        // more completions usually follow the one that woke us, pick them up without sleeping
+        struct timeval zero = {0, 0};
+        uint64_t end = clock_monotonic_ns() + g->busy_poll_ns;
+        while (clock_monotonic_ns() < end && atomic_load_explicit(&g->run, memory_order_relaxed)) {
+            libusb_handle_events_timeout_completed(g->ctx, &zero, NULL);
+            cpu_relax();
+        }
+    }
+    thrd_exit(0);
+}
+
+event_group_t *event_group_get(struct libusb_context *shared_ctx, bool app_driven, const struct candle_event_thread_config *config) {
+    event_group_t *g;
+
+    // shared and sharded groups are looked up, a per-device group is always new
+    if (config->policy != CANDLE_EVENT_THREAD_PER_DEVICE) {
+        list_for_each_entry(g, &event_groups, list) {
+            if (g->policy == config->policy && (config->policy == CANDLE_EVENT_THREAD_SHARED || g->shard == config->shard)) {
+                g->ref_count++;
+                return g;
+            }
+        }
+    }
+
+    g = malloc(sizeof(event_group_t));
+    if (g == NULL)
+        return NULL;
+
+    if (config->policy == CANDLE_EVENT_THREAD_SHARED) {
+        g->ctx = shared_ctx;
+        g->own_ctx = false;
+    } else {
+        if (libusb_init_context(&g->ctx, NULL, 0) != LIBUSB_SUCCESS) {
+            free(g);
+            return NULL;
+        }
+        g->own_ctx = true;
+    }
+    g->app_driven = app_driven;
+    g->policy = config->policy;
+    g->shard = config->shard;
+    g->cpu = config->cpu;
+    g->priority = config->priority;
+    g->busy_poll_ns = (uint64_t)config->busy_poll_us * 1000;
+    g->ref_count = 1;
+    g->open_count = 0;
+    atomic_init(&g->run, false);
+    atomic_init(&g->state, 0);
+    list_add_tail(&g->list, &event_groups);
+    return g;
+}
+
+void event_group_put(event_group_t *g) {
+    if (--g->ref_count != 0)
+        return;
+
+    list_del(&g->list);
+    if (g->own_ctx)
+        libusb_exit(g->ctx);
+    free(g);
+}
+
+bool event_group_after_open(event_group_t *g) {
+    if (++g->open_count != 1 || g->app_driven)
+        return true;
+
+    // start event loop
+    atomic_store(&g->run, true);
+    atomic_store(&g->state, 0);
+    if (thrd_create(&g->thread, event_thread_func, g) != thrd_success) {
+        g->open_count--;
+        return false;
+    }
+
+    // wait until the thread applied its scheduling
+    while (atomic_load(&g->state) == 0)
+        thrd_yield();
+    if (atomic_load(&g->state) < 0) {
+        thrd_join(g->thread, NULL);
+        g->open_count--;
+        return false;
+    }
+    return true;
+}
+
+void event_group_before_close(event_group_t *g) {
+    // stop event loop, libusb_close wakes it up
+    if (--g->open_count == 0 && !g->app_driven)
+        atomic_store(&g->run, false);
+}
+
+void event_group_after_close(event_group_t *g) {
+    // join event loop
+    if (g->open_count == 0 && !g->app_driven)
+        thrd_join(g->thread, NULL);
+}
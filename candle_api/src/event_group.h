@@ -0,0 +1,38 @@
+#ifndef CANDLE_API_EVENT_GROUP_H
+#define CANDLE_API_EVENT_GROUP_H
+
+#include "candle_api.h"
+#include "compiler.h"
+#include "libusb.h"
+#include "list.h"
+#include <stdatomic.h>
+
+// A libusb context with the thread that handles its events.
+// The shared group uses the library context, per-device and sharded groups open their devices in a
+// context of their own so that libusb_handle_events on one thread only completes their transfers.
+// The thread is started by the first open device (taking its cpu, priority and busy poll time) and stopped with the last.
+// An application-driven group has no thread, the application handles the events of its context.
+typedef struct {
+    struct list_head list;
+    struct libusb_context *ctx;
+    bool own_ctx;
+    bool app_driven;
+    enum candle_event_thread_policy policy;
+    uint32_t shard;
+    int cpu;
+    int priority;
+    uint64_t busy_poll_ns;
+    size_t ref_count;       // devices holding the group, open or opening
+    size_t open_count;      // open usb handles, the thread runs while non-zero
+    thrd_t thread;
+    atomic_bool run;
+    atomic_int state;       // 0 starting, 1 running, -1 the scheduling could not be applied
+} event_group_t;
+
+event_group_t *event_group_get(struct libusb_context *shared_ctx, bool app_driven, const struct candle_event_thread_config *config);
+void event_group_put(event_group_t *g);
+bool event_group_after_open(event_group_t *g);
+void event_group_before_close(event_group_t *g);
+void event_group_after_close(event_group_t *g);
+
+#endif // CANDLE_API_EVENT_GROUP_H
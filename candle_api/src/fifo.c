@@ -910,6 +910,35 @@ int fifo_get_noprotect(fifo_t *p_fifo, void *p_element) {
     return (0);
 }
 
+//******************************************************************************************
+//
+//! \brief  Drop the oldest element of FIFO without reading it.
+//!
+//! \param  [in]  pFIFO is the pointer of valid FIFO.
+//!
+//! \retval 0 if operate successfully, otherwise return -1.
+//
+//******************************************************************************************
+int fifo_drop_oldest_noprotect(fifo_t *p_fifo) {
+    //! Check input parameters.
+    ASSERT(p_fifo);
+
+    // Empty ?
+    if (0 == p_fifo->used_num) {
+        //! Error, FIFO is Empty!
+        return (-1);
+    }
+
+    if (p_fifo->p_read_addr > p_fifo->p_end_addr) {
+        p_fifo->p_read_addr = p_fifo->p_start_addr;
+    }
+    p_fifo->p_read_addr += p_fifo->unit_size;
+    p_fifo->free_num++;
+    p_fifo->used_num--;
+
+    return (0);
+}
+
 //******************************************************************************************
 //
 //! \brief  Pre-Read an element from FIFO.
@@ -1025,7 +1054,7 @@ int fifo_flush(fifo_t *p_fifo) {
 
     //! Initialize FIFO Control Block.
     MUTEX_LOCK(p_fifo->mutex);
-    p_fifo->free_num = (p_fifo->p_end_addr - p_fifo->p_start_addr) / (p_fifo->unit_size);
+    p_fifo->free_num = (p_fifo->p_end_addr - p_fifo->p_start_addr + 1) / (p_fifo->unit_size);
     p_fifo->used_num = 0;
     p_fifo->p_read_addr = p_fifo->p_start_addr;
     p_fifo->p_write_addr = p_fifo->p_start_addr;
@@ -314,6 +314,17 @@ int fifo_get(fifo_t *p_fifo, void *p_element);
 
 int fifo_get_noprotect(fifo_t *p_fifo, void *p_element);
 
+//******************************************************************************************
+//
+//! \brief  Drop the oldest element of FIFO without reading it (caller holds the mutex).
+//!
+//! \param  [in]  pFIFO is the pointer of valid FIFO.
+//!
+//! \retval 0 if operate successfully, otherwise return -1.
+//
+//******************************************************************************************
+int fifo_drop_oldest_noprotect(fifo_t *p_fifo);
+
 //******************************************************************************************
 //
 //! \brief  Pre-Read an element from FIFO.
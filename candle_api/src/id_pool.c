@@ -0,0 +1,54 @@
+#include "id_pool.h"
+#include <stdbool.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static __forceinline int ctz32(uint32_t x) {
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return (int)index;
+}
+#else
+#define ctz32(x) __builtin_ctz(x)
+#endif
+
+int id_pool_acquire(id_pool_t *pool) {
+    uint_fast32_t mask = atomic_load_explicit(pool, memory_order_relaxed);
+    while ((uint32_t)mask != UINT32_MAX) {
+        int id = ctz32(~(uint32_t)mask);
+        if (atomic_compare_exchange_weak_explicit(pool, &mask, mask | (1u << id), memory_order_acquire, memory_order_relaxed))
+            return id;
+    }
+    return -1;
+}
+
+uint32_t id_pool_acquire_many(id_pool_t *pool, size_t count) {
+    uint_fast32_t mask = atomic_load_explicit(pool, memory_order_relaxed);
+    while (true) {
+        // pick up to count free ids
+        uint32_t free_ids = ~(uint32_t)mask;
+        uint32_t ids = 0;
+        for (size_t i = 0; i < count && free_ids; ++i) {
+            uint32_t id_bit = free_ids & (~free_ids + 1);
+            ids |= id_bit;
+            free_ids &= ~id_bit;
+        }
+
+        // no id available
+        if (ids == 0)
+            return 0;
+
+        // preempt all of them at once
+        if (atomic_compare_exchange_weak_explicit(pool, &mask, mask | ids, memory_order_acquire, memory_order_relaxed))
+            return ids;
+    }
+}
+
+void id_pool_release(id_pool_t *pool, int id) {
+    atomic_fetch_and(pool, ~(1u << id));
+}
+
+void id_pool_release_many(id_pool_t *pool, uint32_t ids) {
+    atomic_fetch_and(pool, ~ids);
+}
@@ -0,0 +1,18 @@
+#ifndef CANDLE_API_ID_POOL_H
+#define CANDLE_API_ID_POOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free pool of 32 ids, bit n of the mask is set while id n is taken.
+// Acquire finds the lowest free id with a single bit scan and takes it with one compare-exchange,
+// the scan is only repeated if another thread changed the mask in between.
+typedef atomic_uint_fast32_t id_pool_t;
+
+int id_pool_acquire(id_pool_t *pool);
+uint32_t id_pool_acquire_many(id_pool_t *pool, size_t count);
+void id_pool_release(id_pool_t *pool, int id);
+void id_pool_release_many(id_pool_t *pool, uint32_t ids);
+
+#endif // CANDLE_API_ID_POOL_H
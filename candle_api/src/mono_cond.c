@@ -0,0 +1,129 @@
+#include "mono_cond.h"
+#include "clock.h"
+#include <errno.h>
+#include <time.h>
+
+#ifndef MONO_COND_PTHREAD
+#define MONO_COND_SLICE_NS 10000000ull  // longest single wall clock sleep of the fallback
+#endif
+
+void mono_cond_init(mono_cond_t *c) {
+#ifdef MONO_COND_PTHREAD
+    pthread_mutex_init(&c->mtx, NULL);
+#if defined(__APPLE__)
+    pthread_cond_init(&c->cnd, NULL);
+#else
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&c->cnd, &attr);
+    pthread_condattr_destroy(&attr);
+#endif
+#else
+    mtx_init(&c->mtx, mtx_plain);
+    cnd_init(&c->cnd);
+#endif
+}
+
+void mono_cond_destroy(mono_cond_t *c) {
+#ifdef MONO_COND_PTHREAD
+    pthread_cond_destroy(&c->cnd);
+    pthread_mutex_destroy(&c->mtx);
+#else
+    cnd_destroy(&c->cnd);
+    mtx_destroy(&c->mtx);
+#endif
+}
+
+void mono_cond_lock(mono_cond_t *c) {
+#ifdef MONO_COND_PTHREAD
+    pthread_mutex_lock(&c->mtx);
+#else
+    mtx_lock(&c->mtx);
+#endif
+}
+
+void mono_cond_unlock(mono_cond_t *c) {
+#ifdef MONO_COND_PTHREAD
+    pthread_mutex_unlock(&c->mtx);
+#else
+    mtx_unlock(&c->mtx);
+#endif
+}
+
+void mono_cond_wait(mono_cond_t *c) {
+#ifdef MONO_COND_PTHREAD
+    pthread_cond_wait(&c->cnd, &c->mtx);
+#else
+    cnd_wait(&c->cnd, &c->mtx);
+#endif
+}
+
+#ifdef MONO_COND_PTHREAD
+static void ns_to_timespec(uint64_t ns, struct timespec *ts) {
+    ts->tv_sec = (time_t)(ns / 1000000000u);
+    ts->tv_nsec = (long)(ns % 1000000000u);
+}
+#endif
+
+int mono_cond_wait_until(mono_cond_t *c, uint64_t deadline_ns) {
+    uint64_t now = clock_monotonic_ns();
+    if (now >= deadline_ns)
+        return thrd_timedout;
+
+#ifdef MONO_COND_PTHREAD
+    struct timespec ts;
+    int rc;
+#if defined(__APPLE__)
+    // no monotonic condattr, a relative wait does not follow the wall clock either
+    ns_to_timespec(deadline_ns - now, &ts);
+    rc = pthread_cond_timedwait_relative_np(&c->cnd, &c->mtx, &ts);
+#else
+    // clock_monotonic_ns is CLOCK_MONOTONIC, a far deadline is capped to stay within time_t
+    ns_to_timespec(deadline_ns - now > INT32_MAX * 1000000000ull ? now + INT32_MAX * 1000000000ull : deadline_ns, &ts);
+    rc = pthread_cond_timedwait(&c->cnd, &c->mtx, &ts);
+#endif
+    if (rc == 0)
+        return thrd_success;
+    if (rc != ETIMEDOUT)
+        return thrd_error;
+    return clock_monotonic_ns() >= deadline_ns ? thrd_timedout : thrd_success;
+#else
+    // TIME_UTC only, sleep in slices and check the monotonic deadline after each one
+    for (;;) {
+        uint64_t slice = deadline_ns - now < MONO_COND_SLICE_NS ? deadline_ns - now : MONO_COND_SLICE_NS;
+        struct timespec ts;
+        timespec_get(&ts, TIME_UTC);
+        ts.tv_sec += (time_t)(slice / 1000000000u);
+        ts.tv_nsec += (long)(slice % 1000000000u);
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+
+        int rc = cnd_timedwait(&c->cnd, &c->mtx, &ts);
+        if (rc != thrd_timedout)
+            return rc;
+
+        now = clock_monotonic_ns();
+        if (now >= deadline_ns)
+            return thrd_timedout;
+    }
+#endif
+}
+
+void mono_cond_signal(mono_cond_t *c) {
+#ifdef MONO_COND_PTHREAD
+    pthread_cond_signal(&c->cnd);
+#else
+    cnd_signal(&c->cnd);
+#endif
+}
+
+void mono_cond_broadcast(mono_cond_t *c) {
+#ifdef MONO_COND_PTHREAD
+    pthread_cond_broadcast(&c->cnd);
+#else
+    cnd_broadcast(&c->cnd);
+#endif
+}
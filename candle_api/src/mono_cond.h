@@ -0,0 +1,36 @@
+#ifndef CANDLE_API_MONO_COND_H
+#define CANDLE_API_MONO_COND_H
+
+#include "compiler.h"
+#include <stdint.h>
+
+// Mutex and condition variable whose timed wait takes a clock_monotonic_ns deadline.
+// C11 cnd_timedwait sleeps against TIME_UTC, so a wall clock step would end a wait early or
+// stretch it by the size of the step. POSIX waits on CLOCK_MONOTONIC directly (relative waits
+// on macOS). Elsewhere the wait falls back to C11 and sleeps in slices, re-checking the deadline
+// after each one, so a step can stretch a wait by at most one slice.
+#if !defined(_WIN32)
+#define MONO_COND_PTHREAD
+#include <pthread.h>
+#endif
+
+typedef struct {
+#ifdef MONO_COND_PTHREAD
+    pthread_mutex_t mtx;
+    pthread_cond_t cnd;
+#else
+    mtx_t mtx;
+    cnd_t cnd;
+#endif
+} mono_cond_t;
+
+void mono_cond_init(mono_cond_t *c);
+void mono_cond_destroy(mono_cond_t *c);
+void mono_cond_lock(mono_cond_t *c);
+void mono_cond_unlock(mono_cond_t *c);
+void mono_cond_wait(mono_cond_t *c);
+int mono_cond_wait_until(mono_cond_t *c, uint64_t deadline_ns);    // thrd_success when woken (maybe spuriously), thrd_timedout once the deadline passed
+void mono_cond_signal(mono_cond_t *c);
+void mono_cond_broadcast(mono_cond_t *c);
+
+#endif // CANDLE_API_MONO_COND_H
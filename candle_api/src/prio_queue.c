@@ -0,0 +1,114 @@
+#include "prio_queue.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline bool node_before(const prio_node_t *a, const prio_node_t *b) {
+    if (a->key != b->key)
+        return a->key < b->key;
+    return a->seq < b->seq;
+}
+
+prio_queue_t *prio_queue_create(size_t unit_size, size_t unit_cnt) {
+    if (unit_size == 0 || unit_cnt == 0 || unit_cnt > UINT32_MAX)
+        return NULL;
+
+    prio_queue_t *queue = malloc(sizeof(prio_queue_t));
+    if (queue == NULL)
+        return NULL;
+
+    queue->nodes = malloc(unit_cnt * sizeof(prio_node_t));
+    queue->free_slots = malloc(unit_cnt * sizeof(uint32_t));
+    queue->buffer = malloc(unit_cnt * unit_size);
+    if (queue->nodes == NULL || queue->free_slots == NULL || queue->buffer == NULL) {
+        prio_queue_destroy(queue);
+        return NULL;
+    }
+
+    queue->unit_size = unit_size;
+    queue->capacity = unit_cnt;
+    prio_queue_flush(queue);
+    return queue;
+}
+
+void prio_queue_destroy(prio_queue_t *queue) {
+    if (queue == NULL)
+        return;
+
+    free(queue->nodes);
+    free(queue->free_slots);
+    free(queue->buffer);
+    free(queue);
+}
+
+int prio_queue_put(prio_queue_t *queue, uint32_t key, const void *element) {
+    if (queue->used == queue->capacity)
+        return -1;
+
+    // free slots are stacked above the used count
+    prio_node_t node = {.key = key, .slot = queue->free_slots[queue->used], .seq = queue->seq++};
+    memcpy(queue->buffer + (size_t)node.slot * queue->unit_size, element, queue->unit_size);
+
+    // sift up
+    size_t i = queue->used++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!node_before(&node, &queue->nodes[parent]))
+            break;
+        queue->nodes[i] = queue->nodes[parent];
+        i = parent;
+    }
+    queue->nodes[i] = node;
+    return 0;
+}
+
+int prio_queue_get(prio_queue_t *queue, void *element) {
+    if (queue->used == 0)
+        return -1;
+
+    uint32_t slot = queue->nodes[0].slot;
+    memcpy(element, queue->buffer + (size_t)slot * queue->unit_size, queue->unit_size);
+    queue->free_slots[--queue->used] = slot;
+
+    // sift the last node down from the root
+    prio_node_t node = queue->nodes[queue->used];
+    size_t i = 0;
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= queue->used)
+            break;
+        if (child + 1 < queue->used && node_before(&queue->nodes[child + 1], &queue->nodes[child]))
+            child++;
+        if (!node_before(&queue->nodes[child], &node))
+            break;
+        queue->nodes[i] = queue->nodes[child];
+        i = child;
+    }
+    queue->nodes[i] = node;
+    return 0;
+}
+
+const void *prio_queue_peek(prio_queue_t *queue) {
+    if (queue->used == 0)
+        return NULL;
+    return queue->buffer + (size_t)queue->nodes[0].slot * queue->unit_size;
+}
+
+int prio_queue_is_empty(prio_queue_t *queue) {
+    return queue->used == 0;
+}
+
+int prio_queue_is_full(prio_queue_t *queue) {
+    return queue->used == queue->capacity;
+}
+
+size_t prio_queue_used(prio_queue_t *queue) {
+    return queue->used;
+}
+
+void prio_queue_flush(prio_queue_t *queue) {
+    queue->used = 0;
+    queue->seq = 0;
+    for (size_t i = 0; i < queue->capacity; ++i)
+        queue->free_slots[i] = (uint32_t)i;
+}
@@ -0,0 +1,36 @@
+#ifndef CANDLE_API_PRIO_QUEUE_H
+#define CANDLE_API_PRIO_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded binary min-heap of fixed size elements, not thread safe.
+// Elements with the smallest key are popped first, elements with equal keys in insertion order.
+// Only 16 byte nodes move while sifting, the elements stay in their storage slot.
+typedef struct {
+    uint32_t key;
+    uint32_t slot;
+    uint64_t seq;
+} prio_node_t;
+
+typedef struct {
+    size_t unit_size;
+    size_t capacity;
+    size_t used;
+    uint64_t seq;
+    prio_node_t *nodes;
+    uint32_t *free_slots;   // stack of unused storage slots
+    char *buffer;
+} prio_queue_t;
+
+prio_queue_t *prio_queue_create(size_t unit_size, size_t unit_cnt);
+void prio_queue_destroy(prio_queue_t *queue);
+int prio_queue_put(prio_queue_t *queue, uint32_t key, const void *element);
+int prio_queue_get(prio_queue_t *queue, void *element);
+const void *prio_queue_peek(prio_queue_t *queue);
+int prio_queue_is_empty(prio_queue_t *queue);
+int prio_queue_is_full(prio_queue_t *queue);
+size_t prio_queue_used(prio_queue_t *queue);
+void prio_queue_flush(prio_queue_t *queue);
+
+#endif // CANDLE_API_PRIO_QUEUE_H
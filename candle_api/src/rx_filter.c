@@ -0,0 +1,165 @@
+#include "rx_filter.h"
+#include <stdlib.h>
+
+#define STD_ID_MASK 0x7FFu
+#define EXT_ID_MASK 0x1FFFFFFFu
+#define FILTER_FLAGS (CANDLE_RX_FILTER_EXTENDED | CANDLE_RX_FILTER_RANGE | CANDLE_RX_FILTER_DATA_ONLY | CANDLE_RX_FILTER_REMOTE_ONLY | CANDLE_RX_FILTER_ERROR)
+
+static void set_std(rx_filter_t *f, uint32_t id, bool data, bool remote) {
+    if (data)
+        f->std_data[id / 32] |= 1u << (id % 32);
+    if (remote)
+        f->std_remote[id / 32] |= 1u << (id % 32);
+}
+
+static int compare_range(const void *a, const void *b) {
+    const struct rx_filter_range *x = a;
+    const struct rx_filter_range *y = b;
+    return x->first < y->first ? -1 : x->first > y->first;
+}
+
+// sort and merge overlapping or adjacent ranges, returns the new count
+static size_t merge_ranges(struct rx_filter_range *ranges, size_t count) {
+    if (count == 0)
+        return 0;
+
+    qsort(ranges, count, sizeof(struct rx_filter_range), compare_range);
+    size_t n = 0;
+    for (size_t i = 1; i < count; ++i) {
+        if (ranges[i].first <= ranges[n].last + 1) {
+            if (ranges[i].last > ranges[n].last)
+                ranges[n].last = ranges[i].last;
+        } else {
+            ranges[++n] = ranges[i];
+        }
+    }
+    return n + 1;
+}
+
+static bool find_range(const struct rx_filter_range *ranges, size_t count, uint32_t id) {
+    // last range starting at or before id
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ranges[mid].first <= id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo > 0 && id <= ranges[lo - 1].last;
+}
+
+rx_filter_t *rx_filter_create(const struct candle_rx_filter *filters, size_t count) {
+    rx_filter_t *f = calloc(1, sizeof(rx_filter_t));
+    if (f == NULL)
+        return NULL;
+
+    // every filter yields at most one range per frame kind or one mask
+    f->ext_data = malloc(count * sizeof(struct rx_filter_range));
+    f->ext_remote = malloc(count * sizeof(struct rx_filter_range));
+    f->ext_masks = malloc(count * sizeof(struct candle_rx_filter));
+    if (f->ext_data == NULL || f->ext_remote == NULL || f->ext_masks == NULL)
+        goto handle_error;
+
+    for (size_t i = 0; i < count; ++i) {
+        const struct candle_rx_filter *filter = &filters[i];
+        if (filter->flags & ~(uint32_t)FILTER_FLAGS)
+            goto handle_error;
+
+        if (filter->flags & CANDLE_RX_FILTER_ERROR) {
+            f->accept_error = true;
+            continue;
+        }
+
+        bool data = !(filter->flags & CANDLE_RX_FILTER_REMOTE_ONLY);
+        bool remote = !(filter->flags & CANDLE_RX_FILTER_DATA_ONLY);
+        if (!data && !remote)
+            goto handle_error;
+
+        uint32_t id_mask = filter->flags & CANDLE_RX_FILTER_EXTENDED ? EXT_ID_MASK : STD_ID_MASK;
+        uint32_t first;
+        uint32_t last;
+        if (filter->flags & CANDLE_RX_FILTER_RANGE) {
+            if (filter->id > id_mask || filter->last_id < filter->id)
+                goto handle_error;
+            first = filter->id;
+            last = filter->last_id < id_mask ? filter->last_id : id_mask;
+        } else {
+            uint32_t mask = filter->mask & id_mask;
+            uint32_t open = ~mask & id_mask;
+
+            // the 11-bit space is small enough to expand any mask
+            if (id_mask == STD_ID_MASK) {
+                for (uint32_t id = 0; id <= STD_ID_MASK; ++id) {
+                    if ((id & mask) == (filter->id & mask))
+                        set_std(f, id, data, remote);
+                }
+                continue;
+            }
+
+            // open bits below the fixed ones form a range, anything else stays a mask
+            if ((open & (open + 1)) != 0) {
+                f->ext_masks[f->ext_mask_count] = *filter;
+                f->ext_masks[f->ext_mask_count].mask = mask;
+                f->ext_mask_count++;
+                continue;
+            }
+            first = filter->id & mask;
+            last = first | open;
+        }
+
+        if (id_mask == STD_ID_MASK) {
+            for (uint32_t id = first; id <= last; ++id)
+                set_std(f, id, data, remote);
+            continue;
+        }
+
+        struct rx_filter_range range = {first, last};
+        if (data)
+            f->ext_data[f->ext_data_count++] = range;
+        if (remote)
+            f->ext_remote[f->ext_remote_count++] = range;
+    }
+
+    f->ext_data_count = merge_ranges(f->ext_data, f->ext_data_count);
+    f->ext_remote_count = merge_ranges(f->ext_remote, f->ext_remote_count);
+    return f;
+
+handle_error:
+    rx_filter_destroy(f);
+    return NULL;
+}
+
+void rx_filter_destroy(rx_filter_t *f) {
+    if (f == NULL)
+        return;
+
+    free(f->ext_data);
+    free(f->ext_remote);
+    free(f->ext_masks);
+    free(f);
+}
+
+bool rx_filter_match(const rx_filter_t *f, uint32_t can_id, bool extended, bool remote, bool error) {
+    if (error)
+        return f->accept_error;
+
+    if (!extended) {
+        const uint32_t *bitmap = remote ? f->std_remote : f->std_data;
+        can_id &= STD_ID_MASK;
+        return bitmap[can_id / 32] & (1u << (can_id % 32));
+    }
+
+    can_id &= EXT_ID_MASK;
+    if (remote ? find_range(f->ext_remote, f->ext_remote_count, can_id) : find_range(f->ext_data, f->ext_data_count, can_id))
+        return true;
+
+    for (size_t i = 0; i < f->ext_mask_count; ++i) {
+        const struct candle_rx_filter *m = &f->ext_masks[i];
+        if ((can_id & m->mask) == (m->id & m->mask) &&
+            !(m->flags & (remote ? CANDLE_RX_FILTER_DATA_ONLY : CANDLE_RX_FILTER_REMOTE_ONLY)))
+            return true;
+    }
+    return false;
+}
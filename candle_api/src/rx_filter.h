@@ -0,0 +1,34 @@
+#ifndef CANDLE_API_RX_FILTER_H
+#define CANDLE_API_RX_FILTER_H
+
+#include "candle_api.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct rx_filter_range {
+    uint32_t first;
+    uint32_t last;
+};
+
+// Acceptance filter compiled from a list of candle_rx_filter, read by the event thread only.
+// 11-bit ids are looked up in a bitmap with one bit per id for data and one for remote frames.
+// 29-bit ranges, exact ids and masks that only leave low bits open become sorted disjoint ranges
+// found by binary search, other masks are tried one by one.
+typedef struct {
+    uint32_t std_data[2048 / 32];
+    uint32_t std_remote[2048 / 32];
+    struct rx_filter_range *ext_data;
+    size_t ext_data_count;
+    struct rx_filter_range *ext_remote;
+    size_t ext_remote_count;
+    struct candle_rx_filter *ext_masks;
+    size_t ext_mask_count;
+    bool accept_error;
+} rx_filter_t;
+
+rx_filter_t *rx_filter_create(const struct candle_rx_filter *filters, size_t count);
+void rx_filter_destroy(rx_filter_t *f);
+bool rx_filter_match(const rx_filter_t *f, uint32_t can_id, bool extended, bool remote, bool error);
+
+#endif // CANDLE_API_RX_FILTER_H
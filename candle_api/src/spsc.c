@@ -0,0 +1,124 @@
+#include "spsc.h"
+#include <stdlib.h>
+#include <string.h>
+
+spsc_t *spsc_create(size_t unit_size, size_t unit_cnt) {
+    if (unit_size == 0 || unit_cnt == 0)
+        return NULL;
+
+    // round up to power of two
+    size_t size = 1;
+    while (size < unit_cnt)
+        size <<= 1;
+
+    spsc_t *ring = malloc(sizeof(spsc_t));
+    if (ring == NULL)
+        return NULL;
+
+    ring->buffer = malloc(unit_size * size);
+    if (ring->buffer == NULL) {
+        free(ring);
+        return NULL;
+    }
+
+    atomic_init(&ring->head, 0);
+    ring->tail_cache = 0;
+    atomic_init(&ring->tail, 0);
+    ring->head_cache = 0;
+    ring->mask = size - 1;
+    ring->unit_size = unit_size;
+    return ring;
+}
+
+void spsc_destroy(spsc_t *ring) {
+    if (ring == NULL)
+        return;
+
+    free(ring->buffer);
+    free(ring);
+}
+
+int spsc_put(spsc_t *ring, const void *element) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // full, refresh the cached consumer position
+    if (head - ring->tail_cache > ring->mask) {
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - ring->tail_cache > ring->mask)
+            return -1;
+    }
+
+    memcpy(ring->buffer + (head & ring->mask) * ring->unit_size, element, ring->unit_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return 0;
+}
+
+int spsc_get(spsc_t *ring, void *element) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    // empty, refresh the cached producer position
+    if (tail == ring->head_cache) {
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail == ring->head_cache)
+            return -1;
+    }
+
+    memcpy(element, ring->buffer + (tail & ring->mask) * ring->unit_size, ring->unit_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+void *spsc_write_slot(spsc_t *ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // full, refresh the cached consumer position
+    if (head - ring->tail_cache > ring->mask) {
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - ring->tail_cache > ring->mask)
+            return NULL;
+    }
+
+    return ring->buffer + (head & ring->mask) * ring->unit_size;
+}
+
+void spsc_write_commit(spsc_t *ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+const void *spsc_read_span(spsc_t *ring, size_t *count) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    // contiguous elements up to the end of the buffer
+    size_t index = tail & ring->mask;
+    *count = min(ring->head_cache - tail, ring->mask + 1 - index);
+    if (*count == 0)
+        return NULL;
+    return ring->buffer + index * ring->unit_size;
+}
+
+void spsc_read_commit(spsc_t *ring, size_t count) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+}
+
+int spsc_is_empty(spsc_t *ring) {
+    return spsc_used(ring) == 0;
+}
+
+size_t spsc_used(spsc_t *ring) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return head - tail;
+}
+
+size_t spsc_size(spsc_t *ring) {
+    return ring->mask + 1;
+}
+
+void spsc_flush(spsc_t *ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    ring->head_cache = head;
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+}
@@ -0,0 +1,42 @@
+#ifndef CANDLE_API_SPSC_H
+#define CANDLE_API_SPSC_H
+
+#include "compiler.h"
+#include <stdatomic.h>
+
+// Lock-free single-producer / single-consumer ring buffer.
+// Exactly one thread may call spsc_put and exactly one thread may call the consumer side
+// functions (spsc_get, spsc_read_span, spsc_flush) at a time. The capacity is rounded up to a power of two.
+// spsc_flush from another thread is only safe once the reader has stopped and left the ring.
+// spsc_write_slot/spsc_write_commit and spsc_read_span/spsc_read_commit access elements in place.
+typedef struct {
+    // producer side
+    atomic_size_t head;
+    size_t tail_cache;
+    char pad0[CACHE_LINE_SIZE - sizeof(atomic_size_t) - sizeof(size_t)];
+
+    // consumer side
+    atomic_size_t tail;
+    size_t head_cache;
+    char pad1[CACHE_LINE_SIZE - sizeof(atomic_size_t) - sizeof(size_t)];
+
+    // read only
+    size_t mask;
+    size_t unit_size;
+    char *buffer;
+} spsc_t;
+
+spsc_t *spsc_create(size_t unit_size, size_t unit_cnt);
+void spsc_destroy(spsc_t *ring);
+int spsc_put(spsc_t *ring, const void *element);
+int spsc_get(spsc_t *ring, void *element);
+void *spsc_write_slot(spsc_t *ring);
+void spsc_write_commit(spsc_t *ring);
+const void *spsc_read_span(spsc_t *ring, size_t *count);
+void spsc_read_commit(spsc_t *ring, size_t count);
+int spsc_is_empty(spsc_t *ring);
+size_t spsc_used(spsc_t *ring);
+size_t spsc_size(spsc_t *ring);
+void spsc_flush(spsc_t *ring);
+
+#endif // CANDLE_API_SPSC_H
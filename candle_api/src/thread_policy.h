@@ -0,0 +1,12 @@
+#ifndef CANDLE_API_THREAD_POLICY_H
+#define CANDLE_API_THREAD_POLICY_H
+
+#include <stdbool.h>
+
+// Scheduling of the calling thread.
+// Affinity is supported on Linux and Windows, the real-time class on POSIX (SCHED_FIFO, usually needs
+// CAP_SYS_NICE or an rtprio limit) and Windows (time critical priority, the value is not used).
+bool thread_set_affinity(int cpu);          // cpu < 0 keeps the current affinity
+bool thread_set_priority(int priority);     // priority 0 keeps the current scheduling
+
+#endif // CANDLE_API_THREAD_POLICY_H
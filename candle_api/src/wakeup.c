@@ -0,0 +1,58 @@
+#include "wakeup.h"
+
+void wakeup_init(wakeup_t *w) {
+    mono_cond_init(&w->cond);
+    atomic_init(&w->waiters, 0);
+}
+
+void wakeup_destroy(wakeup_t *w) {
+    mono_cond_destroy(&w->cond);
+}
+
+void wakeup_lock(wakeup_t *w) {
+    mono_cond_lock(&w->cond);
+    atomic_fetch_add(&w->waiters, 1);
+
+    // the registration must be visible before the waiter re-checks its condition
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void wakeup_unlock(wakeup_t *w) {
+    atomic_fetch_sub(&w->waiters, 1);
+    mono_cond_unlock(&w->cond);
+}
+
+int wakeup_wait_until(wakeup_t *w, uint64_t deadline_ns) {
+    return mono_cond_wait_until(&w->cond, deadline_ns);
+}
+
+void wakeup_suspend(wakeup_t *w) {
+    // a signal sent meanwhile finds nobody sleeping, the re-check after wakeup_resume covers it
+    mono_cond_unlock(&w->cond);
+}
+
+void wakeup_resume(wakeup_t *w) {
+    mono_cond_lock(&w->cond);
+}
+
+void wakeup_signal(wakeup_t *w) {
+    // pairs with the fence in wakeup_lock: either the waiter sees the change or we see the waiter
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&w->waiters, memory_order_relaxed) == 0)
+        return;
+
+    // the waiter holds the mutex until it sleeps, so the signal cannot be lost
+    mono_cond_lock(&w->cond);
+    mono_cond_signal(&w->cond);
+    mono_cond_unlock(&w->cond);
+}
+
+void wakeup_broadcast(wakeup_t *w) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&w->waiters, memory_order_relaxed) == 0)
+        return;
+
+    mono_cond_lock(&w->cond);
+    mono_cond_broadcast(&w->cond);
+    mono_cond_unlock(&w->cond);
+}
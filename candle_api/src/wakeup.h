@@ -0,0 +1,28 @@
+#ifndef CANDLE_API_WAKEUP_H
+#define CANDLE_API_WAKEUP_H
+
+#include "compiler.h"
+#include "mono_cond.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Condition variable that is only signalled while somebody waits on it.
+// A waiter calls wakeup_lock, re-checks its condition, waits with wakeup_wait_until and
+// leaves with wakeup_unlock. The notifier makes its change visible first and then calls
+// wakeup_signal, which does not touch the mutex when no waiter is registered.
+typedef struct {
+    mono_cond_t cond;
+    atomic_uint waiters;
+} wakeup_t;
+
+void wakeup_init(wakeup_t *w);
+void wakeup_destroy(wakeup_t *w);
+void wakeup_lock(wakeup_t *w);
+void wakeup_unlock(wakeup_t *w);
+int wakeup_wait_until(wakeup_t *w, uint64_t deadline_ns);  // deadline on clock_monotonic_ns
+void wakeup_suspend(wakeup_t *w);   // drop the mutex but stay registered, the condition must be re-checked after wakeup_resume
+void wakeup_resume(wakeup_t *w);
+void wakeup_signal(wakeup_t *w);
+void wakeup_broadcast(wakeup_t *w);
+
+#endif // CANDLE_API_WAKEUP_H
@@ -5,6 +5,10 @@ from candle_api.bindings import (
     CandleState,
     CandleFeature,
     CandleBitTimingConst,
+    CandleChannelStats,
+    CandleTxQueueStats,
+    CandleCyclicStats,
+    CandleRxFilter,
     CandleChannel,
     CandleDevice,
     list_device
@@ -17,6 +21,10 @@ __all__ = [
     'CandleState',
     'CandleFeature',
     'CandleBitTimingConst',
+    'CandleChannelStats',
+    'CandleTxQueueStats',
+    'CandleCyclicStats',
+    'CandleRxFilter',
     'CandleChannel',
     'CandleDevice',
     'list_device'
@@ -34,9 +34,13 @@ class CandleFrameType:
     def error_state_indicator(self) -> bool:
         ...
 
+    @property
+    def overflow(self) -> bool:
+        ...
+
 
 class CandleCanFrame:
-    def __init__(self, frame_type: CandleFrameType, can_id: int, can_dlc: int, data: Buffer) -> None:
+    def __init__(self, frame_type: CandleFrameType, can_id: int, can_dlc: int, data: Buffer, tag: int = 0) -> None:
         ...
 
     def __buffer__(self, flags: int) -> memoryview:
@@ -73,6 +77,18 @@ class CandleCanFrame:
     def timestamp(self) -> float:
         ...
 
+    @property
+    def timestamp_host_ns(self) -> int:
+        ...
+
+    @property
+    def receive_host_ns(self) -> int:
+        ...
+
+    @property
+    def tag(self) -> int:
+        ...
+
 
 class CandleCanState:
     @property
@@ -190,6 +206,121 @@ class CandleBitTimingConst:
         ...
 
 
+class CandleChannelStats:
+    @property
+    def tx_pool_exhausted(self) -> int:
+        ...
+
+    @property
+    def rx_dropped(self) -> int:
+        ...
+
+    @property
+    def rx_frames(self) -> int:
+        ...
+
+    @property
+    def device_overflows(self) -> int:
+        ...
+
+    @property
+    def tx_usb_errors(self) -> int:
+        ...
+
+    @property
+    def tx_usb_resubmits(self) -> int:
+        ...
+
+    @property
+    def rx_usb_errors(self) -> int:
+        ...
+
+    @property
+    def rx_usb_resubmits(self) -> int:
+        ...
+
+    @property
+    def rx_filter_accepted(self) -> int:
+        ...
+
+    @property
+    def rx_filter_rejected(self) -> int:
+        ...
+
+
+class CandleRxFilter:
+    def __init__(self, can_id: int = 0, mask: Optional[int] = None, last_id: Optional[int] = None, extended_id: bool = False, data_only: bool = False, remote_only: bool = False, error_frames: bool = False) -> None:
+        ...
+
+    @property
+    def can_id(self) -> int:
+        ...
+
+    @property
+    def mask(self) -> int:
+        ...
+
+    @property
+    def last_id(self) -> Optional[int]:
+        ...
+
+    @property
+    def extended_id(self) -> bool:
+        ...
+
+
+class CandleTxQueueStats:
+    @property
+    def frames(self) -> list[int]:
+        ...
+
+    @property
+    def delay_sum_ns(self) -> list[int]:
+        ...
+
+    @property
+    def delay_max_ns(self) -> list[int]:
+        ...
+
+    @property
+    def queue_full(self) -> int:
+        ...
+
+    @property
+    def send_errors(self) -> int:
+        ...
+
+    @property
+    def queued(self) -> int:
+        ...
+
+
+class CandleCyclicStats:
+    @property
+    def sent(self) -> int:
+        ...
+
+    @property
+    def send_errors(self) -> int:
+        ...
+
+    @property
+    def missed(self) -> int:
+        ...
+
+    @property
+    def jitter_min_ns(self) -> int:
+        ...
+
+    @property
+    def jitter_max_ns(self) -> int:
+        ...
+
+    @property
+    def jitter_mean_ns(self) -> float:
+        ...
+
+
 class CandleChannel:
     @property
     def feature(self) -> CandleFeature:
@@ -211,10 +342,33 @@ class CandleChannel:
     def state(self) -> CandleState:
         ...
 
+    @property
+    def stats(self) -> CandleChannelStats:
+        ...
+
+    @property
+    def tx_queue_stats(self) -> CandleTxQueueStats:
+        ...
+
     @property
     def termination(self) -> bool:
         ...
 
+    def set_multi_reader(self, enable: bool) -> None:
+        ...
+
+    def set_rx_overflow_policy(self, drop_oldest: bool) -> None:
+        ...
+
+    def set_rx_queue_depth(self, depth: int) -> None:
+        ...
+
+    def set_tx_queue_depth(self, depth: int) -> None:
+        ...
+
+    def set_rx_filters(self, filters: list[CandleRxFilter]) -> None:
+        ...
+
     def reset(self) -> None:
         ...
 
@@ -236,12 +390,33 @@ class CandleChannel:
     def receive_nowait(self) -> Optional[CandleCanFrame]:
         ...
 
+    def send_at(self, frame: CandleCanFrame, monotonic_ns: int) -> None:
+        ...
+
+    def add_cyclic_frame(self, frame: CandleCanFrame, period: float) -> int:
+        ...
+
+    def update_cyclic_frame(self, id: int, frame: CandleCanFrame, period: float) -> None:
+        ...
+
+    def remove_cyclic_frame(self, id: int) -> None:
+        ...
+
+    def get_cyclic_stats(self, id: int) -> CandleCyclicStats:
+        ...
+
     def send(self, frame: CandleCanFrame, timeout: float) -> None:
         ...
 
+    def send_frames(self, frames: list[CandleCanFrame], timeout: float) -> int:
+        ...
+
     def receive(self, timeout: float) -> CandleCanFrame:
         ...
 
+    def receive_frames(self, max_count: int, timeout: float) -> list[CandleCanFrame]:
+        ...
+
 
 class CandleDevice:
 
@@ -291,6 +466,18 @@ class CandleDevice:
     def hardware_version(self) -> int:
         ...
 
+    def set_rx_transfer_count(self, count: int) -> None:
+        ...
+
+    def set_event_thread(self, per_device: bool = False, shard: Optional[int] = None, cpu: int = -1, priority: int = 0, busy_poll_us: int = 0) -> None:
+        ...
+
+    def set_busy_poll(self, microseconds: int) -> None:
+        ...
+
+    def set_tx_schedule_spin(self, microseconds: int) -> None:
+        ...
+
     def open(self) -> None:
         ...
 
@@ -300,6 +487,16 @@ class CandleDevice:
     def wait_for_frame(self, timeout: float) -> bool:
         ...
 
+    def wait_for_channels(self, timeout: float) -> list[int]:
+        ...
+
+    @property
+    def event_fd(self) -> int:
+        ...
+
+    def reset_event_fd(self) -> None:
+        ...
+
 
 def list_device() -> list[CandleDevice]:
     ...
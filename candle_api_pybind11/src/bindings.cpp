@@ -91,6 +91,10 @@ public:
         return ft_ & CANDLE_FRAME_TYPE_ESI;
     }
 
+    bool getOverflow() {
+        return ft_ & CANDLE_FRAME_TYPE_OVERFLOW;
+    }
+
 private:
     candle_frame_type ft_;
 
@@ -101,7 +105,7 @@ class CandleCanFrame {
 public:
     explicit CandleCanFrame(const candle_can_frame& frame): frame_(frame) { }
 
-    CandleCanFrame(const CandleFrameType& frame_type, uint32_t can_id, uint8_t can_dlc, const py::buffer& data): frame_() {
+    CandleCanFrame(const CandleFrameType& frame_type, uint32_t can_id, uint8_t can_dlc, const py::buffer& data, uint64_t tag): frame_() {
         if (can_dlc > 15)
             throw py::value_error("DLC can only be between 0 and 15");
         size_t required_data_len = dlc2len[can_dlc];
@@ -115,6 +119,7 @@ public:
         frame_.type = frame_type.ft_;
         frame_.can_id = can_id;
         frame_.can_dlc = can_dlc;
+        frame_.tag = tag;
 
         std::memcpy(frame_.data, info.ptr, required_data_len);
     }
@@ -139,7 +144,7 @@ public:
         return dlc2len[frame_.can_dlc];
     }
 
-    uint32_t getTimestampUs() {
+    uint64_t getTimestampUs() {
         return frame_.timestamp_us;
     }
 
@@ -147,6 +152,18 @@ public:
         return frame_.timestamp_us / 1e6;
     }
 
+    uint64_t getTimestampHostNs() {
+        return frame_.timestamp_host_ns;
+    }
+
+    uint64_t getReceiveHostNs() {
+        return frame_.receive_host_ns;
+    }
+
+    uint64_t getTag() {
+        return frame_.tag;
+    }
+
     py::buffer_info getBuffer() {
         return py::buffer_info(
             frame_.data,
@@ -304,6 +321,165 @@ private:
     candle_state st_;
 };
 
+class CandleRxFilter {
+public:
+    CandleRxFilter(uint32_t can_id, std::optional<uint32_t> mask, std::optional<uint32_t> last_id, bool extended_id, bool data_only, bool remote_only, bool error_frames): filter_() {
+        int flags = 0;
+        if (extended_id)
+            flags |= CANDLE_RX_FILTER_EXTENDED;
+        if (last_id.has_value())
+            flags |= CANDLE_RX_FILTER_RANGE;
+        if (data_only)
+            flags |= CANDLE_RX_FILTER_DATA_ONLY;
+        if (remote_only)
+            flags |= CANDLE_RX_FILTER_REMOTE_ONLY;
+        if (error_frames)
+            flags |= CANDLE_RX_FILTER_ERROR;
+
+        // an exact id unless a mask or a range is given
+        filter_.id = can_id;
+        filter_.mask = mask.value_or(0x1FFFFFFF);
+        filter_.last_id = last_id.value_or(0);
+        filter_.flags = flags;
+    }
+
+    uint32_t getCanId() {
+        return filter_.id;
+    }
+
+    uint32_t getMask() {
+        return filter_.mask;
+    }
+
+    std::optional<uint32_t> getLastId() {
+        if (filter_.flags & CANDLE_RX_FILTER_RANGE)
+            return filter_.last_id;
+        return std::nullopt;
+    }
+
+    bool getExtendedId() {
+        return filter_.flags & CANDLE_RX_FILTER_EXTENDED;
+    }
+
+private:
+    candle_rx_filter filter_;
+
+    friend class CandleChannel;
+};
+
+class CandleChannelStats {
+public:
+    explicit CandleChannelStats(const candle_channel_stats& stats): stats_(stats) { }
+
+    uint64_t getTxPoolExhausted() {
+        return stats_.tx_pool_exhausted;
+    }
+
+    uint64_t getRxDropped() {
+        return stats_.rx_dropped;
+    }
+
+    uint64_t getRxFrames() {
+        return stats_.rx_frames;
+    }
+
+    uint64_t getDeviceOverflows() {
+        return stats_.device_overflows;
+    }
+
+    uint64_t getTxUsbErrors() {
+        return stats_.tx_usb_errors;
+    }
+
+    uint64_t getTxUsbResubmits() {
+        return stats_.tx_usb_resubmits;
+    }
+
+    uint64_t getRxUsbErrors() {
+        return stats_.rx_usb_errors;
+    }
+
+    uint64_t getRxUsbResubmits() {
+        return stats_.rx_usb_resubmits;
+    }
+
+    uint64_t getRxFilterAccepted() {
+        return stats_.rx_filter_accepted;
+    }
+
+    uint64_t getRxFilterRejected() {
+        return stats_.rx_filter_rejected;
+    }
+
+private:
+    candle_channel_stats stats_;
+};
+
+class CandleTxQueueStats {
+public:
+    explicit CandleTxQueueStats(const candle_tx_queue_stats& stats): stats_(stats) { }
+
+    std::vector<uint64_t> getFrames() {
+        return { std::begin(stats_.frames), std::end(stats_.frames) };
+    }
+
+    std::vector<uint64_t> getDelaySumNs() {
+        return { std::begin(stats_.delay_sum_ns), std::end(stats_.delay_sum_ns) };
+    }
+
+    std::vector<uint64_t> getDelayMaxNs() {
+        return { std::begin(stats_.delay_max_ns), std::end(stats_.delay_max_ns) };
+    }
+
+    uint64_t getQueueFull() {
+        return stats_.queue_full;
+    }
+
+    uint64_t getSendErrors() {
+        return stats_.send_errors;
+    }
+
+    uint64_t getQueued() {
+        return stats_.queued;
+    }
+
+private:
+    candle_tx_queue_stats stats_;
+};
+
+class CandleCyclicStats {
+public:
+    explicit CandleCyclicStats(const candle_cyclic_stats& stats): stats_(stats) { }
+
+    uint64_t getSent() {
+        return stats_.sent;
+    }
+
+    uint64_t getSendErrors() {
+        return stats_.send_errors;
+    }
+
+    uint64_t getMissed() {
+        return stats_.missed;
+    }
+
+    uint64_t getJitterMinNs() {
+        return stats_.jitter_min_ns;
+    }
+
+    uint64_t getJitterMaxNs() {
+        return stats_.jitter_max_ns;
+    }
+
+    double getJitterMeanNs() {
+        uint64_t cycles = stats_.sent + stats_.send_errors;
+        return cycles == 0 ? 0 : (double)stats_.jitter_sum_ns / (double)cycles;
+    }
+
+private:
+    candle_cyclic_stats stats_;
+};
+
 class CandleChannel: public CandleDeviceReference {
 public:
     explicit CandleChannel(candle_device* device, uint8_t index): CandleDeviceReference(device), index_(index) { }
@@ -331,6 +507,20 @@ public:
         return CandleState(st);
     }
 
+    CandleChannelStats getStats() {
+        candle_channel_stats stats;
+        if (!candle_get_channel_stats(device_, index_, &stats))
+            throw std::runtime_error("Cannot get channel stats");
+        return CandleChannelStats(stats);
+    }
+
+    CandleTxQueueStats getTxQueueStats() {
+        candle_tx_queue_stats stats;
+        if (!candle_get_tx_queue_stats(device_, index_, &stats))
+            throw std::runtime_error("Cannot get tx queue stats");
+        return CandleTxQueueStats(stats);
+    }
+
     bool getTermination() {
         bool enable;
 
@@ -345,6 +535,34 @@ public:
             throw std::runtime_error("Cannot set termination");
     }
 
+    void setMultiReader(bool enable) {
+        if (!candle_set_rx_queue_type(device_, index_, enable ? CANDLE_RX_QUEUE_LOCKED : CANDLE_RX_QUEUE_SPSC))
+            throw std::runtime_error("Cannot set rx queue type");
+    }
+
+    void setRxOverflowPolicy(bool dropOldest) {
+        if (!candle_set_rx_overflow_policy(device_, index_, dropOldest ? CANDLE_RX_OVERFLOW_DROP_OLDEST : CANDLE_RX_OVERFLOW_DROP_NEWEST))
+            throw std::runtime_error("Cannot set rx overflow policy");
+    }
+
+    void setRxQueueDepth(size_t depth) {
+        if (!candle_set_rx_queue_depth(device_, index_, depth))
+            throw std::runtime_error("Cannot set rx queue depth");
+    }
+
+    void setTxQueueDepth(size_t depth) {
+        if (!candle_set_tx_queue_depth(device_, index_, depth))
+            throw std::runtime_error("Cannot set tx queue depth");
+    }
+
+    void setRxFilters(const std::vector<CandleRxFilter>& filters) {
+        std::vector<candle_rx_filter> list;
+        for (const auto& f: filters)
+            list.push_back(f.filter_);
+        if (!candle_set_rx_filters(device_, index_, list.data(), list.size()))
+            throw std::runtime_error("Cannot set rx filters");
+    }
+
     void reset() {
         if (!candle_reset_channel(device_, index_))
             throw std::runtime_error("Cannot reset channel");
@@ -393,6 +611,35 @@ public:
             throw std::runtime_error("Cannot send frame");
     }
 
+    void sendAt(CandleCanFrame& frame, uint64_t monotonic_ns) {
+        if (!candle_send_frame_at(device_, index_, &frame.frame_, monotonic_ns))
+            throw std::runtime_error("Cannot schedule frame");
+    }
+
+    uint32_t addCyclicFrame(CandleCanFrame& frame, float period) {
+        uint32_t id;
+        if (!candle_add_cyclic_frame(device_, index_, &frame.frame_, (uint32_t)(1000000 * period), &id))
+            throw std::runtime_error("Cannot add cyclic frame");
+        return id;
+    }
+
+    void updateCyclicFrame(uint32_t id, CandleCanFrame& frame, float period) {
+        if (!candle_update_cyclic_frame(device_, id, &frame.frame_, (uint32_t)(1000000 * period)))
+            throw std::runtime_error("Cannot update cyclic frame");
+    }
+
+    void removeCyclicFrame(uint32_t id) {
+        if (!candle_remove_cyclic_frame(device_, id))
+            throw std::runtime_error("Cannot remove cyclic frame");
+    }
+
+    CandleCyclicStats getCyclicStats(uint32_t id) {
+        candle_cyclic_stats stats;
+        if (!candle_get_cyclic_stats(device_, id, &stats))
+            throw std::runtime_error("Cannot get cyclic stats");
+        return CandleCyclicStats(stats);
+    }
+
     std::optional<CandleCanFrame> receiveNowait() {
         candle_can_frame frame;
         if (!candle_receive_frame_nowait(device_, index_, &frame))
@@ -405,7 +652,7 @@ public:
 
         {
             py::gil_scoped_release release;
-            ret = candle_send_frame(device_, index_, &frame.frame_, (uint32_t)(1000 * timeout));
+            ret = candle_send_frame_us(device_, index_, &frame.frame_, (uint64_t)(1000000 * timeout));
         }
 
         if (!ret) {
@@ -414,13 +661,35 @@ public:
         }
     }
 
+    size_t sendFrames(std::vector<CandleCanFrame>& frames, float timeout) {
+        std::vector<candle_can_frame> burst;
+        size_t sent;
+        bool ret;
+
+        for (auto& frame : frames) {
+            burst.push_back(frame.frame_);
+        }
+
+        {
+            py::gil_scoped_release release;
+            ret = candle_send_frames_us(device_, index_, burst.data(), burst.size(), (uint64_t)(1000000 * timeout), &sent);
+        }
+
+        if (!ret) {
+            PyErr_SetString(PyExc_TimeoutError, "Send timeout");
+            throw py::error_already_set();
+        }
+
+        return sent;
+    }
+
     CandleCanFrame receive(float timeout) {
         candle_can_frame frame;
         bool ret;
 
         {
             py::gil_scoped_release release;
-            ret = candle_receive_frame(device_, index_, &frame, (uint32_t)(1000 * timeout));
+            ret = candle_receive_frame_us(device_, index_, &frame, (uint64_t)(1000000 * timeout));
         }
 
         if (!ret) {
@@ -431,6 +700,34 @@ public:
         return CandleCanFrame(frame);
     }
 
+    std::vector<CandleCanFrame> receiveFrames(size_t max_count, float timeout) {
+        std::vector<candle_can_frame> frames(max_count);
+        size_t count;
+        bool ret;
+
+        {
+            py::gil_scoped_release release;
+            ret = candle_receive_frames_us(device_, index_, frames.data(), max_count, (uint64_t)(1000000 * timeout), &count);
+        }
+
+        // a non-blocking drain of an empty queue is not a timeout
+        if (!ret && timeout == 0)
+            return {};
+
+        if (!ret) {
+            PyErr_SetString(PyExc_TimeoutError, "Receive timeout");
+            throw py::error_already_set();
+        }
+
+        std::vector<CandleCanFrame> list;
+
+        for (size_t i = 0; i < count; ++i) {
+            list.emplace_back(frames[i]);
+        }
+
+        return list;
+    }
+
 private:
     uint8_t index_;
 };
@@ -479,6 +776,34 @@ public:
         return device_->hardware_version;
     }
 
+    void setRxTransferCount(size_t count) {
+        if (!candle_set_rx_transfer_count(device_, count))
+            throw std::runtime_error("Cannot set rx transfer count");
+    }
+
+    void setEventThread(bool per_device, std::optional<uint32_t> shard, int cpu, int priority, uint32_t busy_poll_us) {
+        candle_event_thread_config config = { CANDLE_EVENT_THREAD_SHARED, 0, cpu, priority, busy_poll_us };
+        if (per_device)
+            config.policy = CANDLE_EVENT_THREAD_PER_DEVICE;
+        else if (shard.has_value()) {
+            config.policy = CANDLE_EVENT_THREAD_SHARDED;
+            config.shard = shard.value();
+        }
+
+        if (!candle_set_event_thread(device_, &config))
+            throw std::runtime_error("Cannot set event thread");
+    }
+
+    void setBusyPoll(uint32_t microseconds) {
+        if (!candle_set_busy_poll(device_, microseconds))
+            throw std::runtime_error("Cannot set busy poll");
+    }
+
+    void setTxScheduleSpin(uint32_t microseconds) {
+        if (!candle_set_tx_schedule_spin(device_, microseconds))
+            throw std::runtime_error("Cannot set tx schedule spin");
+    }
+
     void open() {
         if (!candle_open_device(device_))
             throw std::runtime_error("Cannot open device");
@@ -501,7 +826,36 @@ public:
 
     bool waitForFrame(float timeout) {
         py::gil_scoped_release release;
-        return candle_wait_for_frame(device_, (uint32_t)(1000 * timeout));
+        return candle_wait_for_frame_us(device_, (uint64_t)(1000000 * timeout));
+    }
+
+    std::vector<size_t> waitForChannels(float timeout) {
+        std::vector<size_t> depths(device_->channel_count);
+        uint32_t ready;
+        bool ret;
+
+        {
+            py::gil_scoped_release release;
+            ret = candle_wait_for_channels_us(device_, (uint64_t)(1000000 * timeout), &ready, depths.data());
+        }
+
+        if (!ret) {
+            PyErr_SetString(PyExc_TimeoutError, "Wait timeout");
+            throw py::error_already_set();
+        }
+
+        return depths;
+    }
+
+    int getEventFd() {
+        int fd;
+        if (!candle_get_event_fd(device_, &fd))
+            throw std::runtime_error("Cannot get event fd");
+        return fd;
+    }
+
+    void resetEventFd() {
+        candle_reset_event_fd(device_);
     }
 };
 
@@ -533,10 +887,11 @@ PYBIND11_MODULE(bindings, m) {
         .def_property_readonly("error_frame", &CandleFrameType::getErrorFrame)
         .def_property_readonly("fd", &CandleFrameType::getFD)
         .def_property_readonly("bitrate_switch", &CandleFrameType::getBitrateSwitch)
-        .def_property_readonly("error_state_indicator", &CandleFrameType::getErrorStateIndicator);
+        .def_property_readonly("error_state_indicator", &CandleFrameType::getErrorStateIndicator)
+        .def_property_readonly("overflow", &CandleFrameType::getOverflow);
 
     py::class_<CandleCanFrame>(m, "CandleCanFrame", py::buffer_protocol())
-        .def(py::init<const CandleFrameType&, uint32_t, uint8_t, const py::buffer&>(), py::arg("frame_type"), py::arg("can_id"), py::arg("can_dlc"), py::arg("data"))
+        .def(py::init<const CandleFrameType&, uint32_t, uint8_t, const py::buffer&, uint64_t>(), py::arg("frame_type"), py::arg("can_id"), py::arg("can_dlc"), py::arg("data"), py::arg("tag") = 0)
         .def_property_readonly("frame_type", &CandleCanFrame::getFrameType)
         .def_property_readonly("can_id", &CandleCanFrame::getCanId)
         .def_property_readonly("can_dlc", &CandleCanFrame::getCanDLC)
@@ -544,6 +899,9 @@ PYBIND11_MODULE(bindings, m) {
         .def_property_readonly("data", &CandleCanFrame::getData)
         .def_property_readonly("timestamp_us", &CandleCanFrame::getTimestampUs)
         .def_property_readonly("timestamp", &CandleCanFrame::getTimestamp)
+        .def_property_readonly("timestamp_host_ns", &CandleCanFrame::getTimestampHostNs)
+        .def_property_readonly("receive_host_ns", &CandleCanFrame::getReceiveHostNs)
+        .def_property_readonly("tag", &CandleCanFrame::getTag)
         .def_buffer(&CandleCanFrame::getBuffer);
 
     py::class_<CandleFeature>(m, "CandleFeature")
@@ -581,13 +939,55 @@ PYBIND11_MODULE(bindings, m) {
         .def_property_readonly("stopped", &CandleCanState::getStopped)
         .def_property_readonly("sleeping", &CandleCanState::getSleeping);
 
+    py::class_<CandleChannelStats>(m, "CandleChannelStats")
+        .def_property_readonly("tx_pool_exhausted", &CandleChannelStats::getTxPoolExhausted)
+        .def_property_readonly("rx_dropped", &CandleChannelStats::getRxDropped)
+        .def_property_readonly("rx_frames", &CandleChannelStats::getRxFrames)
+        .def_property_readonly("device_overflows", &CandleChannelStats::getDeviceOverflows)
+        .def_property_readonly("tx_usb_errors", &CandleChannelStats::getTxUsbErrors)
+        .def_property_readonly("tx_usb_resubmits", &CandleChannelStats::getTxUsbResubmits)
+        .def_property_readonly("rx_usb_errors", &CandleChannelStats::getRxUsbErrors)
+        .def_property_readonly("rx_usb_resubmits", &CandleChannelStats::getRxUsbResubmits)
+        .def_property_readonly("rx_filter_accepted", &CandleChannelStats::getRxFilterAccepted)
+        .def_property_readonly("rx_filter_rejected", &CandleChannelStats::getRxFilterRejected);
+
+    py::class_<CandleRxFilter>(m, "CandleRxFilter")
+        .def(py::init<uint32_t, std::optional<uint32_t>, std::optional<uint32_t>, bool, bool, bool, bool>(), py::arg("can_id") = 0, py::arg("mask") = std::nullopt, py::arg("last_id") = std::nullopt, py::arg("extended_id") = false, py::arg("data_only") = false, py::arg("remote_only") = false, py::arg("error_frames") = false)
+        .def_property_readonly("can_id", &CandleRxFilter::getCanId)
+        .def_property_readonly("mask", &CandleRxFilter::getMask)
+        .def_property_readonly("last_id", &CandleRxFilter::getLastId)
+        .def_property_readonly("extended_id", &CandleRxFilter::getExtendedId);
+
+    py::class_<CandleTxQueueStats>(m, "CandleTxQueueStats")
+        .def_property_readonly("frames", &CandleTxQueueStats::getFrames)
+        .def_property_readonly("delay_sum_ns", &CandleTxQueueStats::getDelaySumNs)
+        .def_property_readonly("delay_max_ns", &CandleTxQueueStats::getDelayMaxNs)
+        .def_property_readonly("queue_full", &CandleTxQueueStats::getQueueFull)
+        .def_property_readonly("send_errors", &CandleTxQueueStats::getSendErrors)
+        .def_property_readonly("queued", &CandleTxQueueStats::getQueued);
+
+    py::class_<CandleCyclicStats>(m, "CandleCyclicStats")
+        .def_property_readonly("sent", &CandleCyclicStats::getSent)
+        .def_property_readonly("send_errors", &CandleCyclicStats::getSendErrors)
+        .def_property_readonly("missed", &CandleCyclicStats::getMissed)
+        .def_property_readonly("jitter_min_ns", &CandleCyclicStats::getJitterMinNs)
+        .def_property_readonly("jitter_max_ns", &CandleCyclicStats::getJitterMaxNs)
+        .def_property_readonly("jitter_mean_ns", &CandleCyclicStats::getJitterMeanNs);
+
     py::class_<CandleChannel>(m, "CandleChannel")
         .def_property_readonly("feature", &CandleChannel::getFeature)
         .def_property_readonly("clock_frequency", &CandleChannel::getClockFrequency)
         .def_property_readonly("nominal_bit_timing_const", &CandleChannel::getNominalBitTimingConst)
         .def_property_readonly("data_bit_timing_const", &CandleChannel::getDataBitTimingConst)
         .def_property_readonly("state", &CandleChannel::getState)
+        .def_property_readonly("stats", &CandleChannel::getStats)
+        .def_property_readonly("tx_queue_stats", &CandleChannel::getTxQueueStats)
         .def_property_readonly("termination", &CandleChannel::getTermination)
+        .def("set_multi_reader", &CandleChannel::setMultiReader)
+        .def("set_rx_overflow_policy", &CandleChannel::setRxOverflowPolicy, py::arg("drop_oldest"))
+        .def("set_rx_queue_depth", &CandleChannel::setRxQueueDepth)
+        .def("set_tx_queue_depth", &CandleChannel::setTxQueueDepth)
+        .def("set_rx_filters", &CandleChannel::setRxFilters)
         .def("reset", &CandleChannel::reset)
         .def("start", &CandleChannel::start, py::arg("listen_only") = false, py::arg("loop_back") = false, py::arg("triple_sample") = false, py::arg("one_shot") = false, py::arg("hardware_timestamp") = false, py::arg("pad_package") = false, py::arg("fd") = false, py::arg("bit_error_reporting") = false)
         .def("set_bit_timing", &CandleChannel::setBitTiming)
@@ -595,8 +995,15 @@ PYBIND11_MODULE(bindings, m) {
         .def("set_termination", &CandleChannel::setTermination)
         .def("send_nowait", &CandleChannel::sendNowait)
         .def("receive_nowait", &CandleChannel::receiveNowait)
+        .def("send_at", &CandleChannel::sendAt)
+        .def("add_cyclic_frame", &CandleChannel::addCyclicFrame)
+        .def("update_cyclic_frame", &CandleChannel::updateCyclicFrame)
+        .def("remove_cyclic_frame", &CandleChannel::removeCyclicFrame)
+        .def("get_cyclic_stats", &CandleChannel::getCyclicStats)
         .def("send", &CandleChannel::send)
-        .def("receive", &CandleChannel::receive);
+        .def("send_frames", &CandleChannel::sendFrames)
+        .def("receive", &CandleChannel::receive)
+        .def("receive_frames", &CandleChannel::receiveFrames);
 
     py::class_<CandleDevice>(m, "CandleDevice")
         .def_property_readonly("is_connected", &CandleDevice::getIsConnected)
@@ -609,11 +1016,18 @@ PYBIND11_MODULE(bindings, m) {
         .def_property_readonly("channel_count", &CandleDevice::getChannelCount)
         .def_property_readonly("software_version", &CandleDevice::getSoftwareVersion)
         .def_property_readonly("hardware_version", &CandleDevice::getHardwareVersion)
+        .def("set_rx_transfer_count", &CandleDevice::setRxTransferCount)
+        .def("set_event_thread", &CandleDevice::setEventThread, py::arg("per_device") = false, py::arg("shard") = std::nullopt, py::arg("cpu") = -1, py::arg("priority") = 0, py::arg("busy_poll_us") = 0)
+        .def("set_busy_poll", &CandleDevice::setBusyPoll)
+        .def("set_tx_schedule_spin", &CandleDevice::setTxScheduleSpin)
         .def("open", &CandleDevice::open)
         .def("close", &CandleDevice::close)
         .def("__getitem__", &CandleDevice::getChannel)
         .def("__len__", &CandleDevice::getChannelCount)
-        .def("wait_for_frame", &CandleDevice::waitForFrame);
+        .def("wait_for_frame", &CandleDevice::waitForFrame)
+        .def("wait_for_channels", &CandleDevice::waitForChannels)
+        .def_property_readonly("event_fd", &CandleDevice::getEventFd)
+        .def("reset_event_fd", &CandleDevice::resetEventFd);
 
     m.def("list_device", list_device);
 }
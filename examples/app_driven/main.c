@@ -0,0 +1,113 @@
+#include "candle_api.h"
+#include <stdio.h>
+#include <signal.h>
+#include <poll.h>
+
+#define MAX_POLLFDS 16
+#define CYCLE_US 1000
+
+
+static bool interrupt;
+
+
+void signal_handle(int signal) {
+    interrupt = true;
+}
+
+
+int main(int argc, char *argv[]) {
+    bool success;
+
+    // catch signal to exit
+    signal(SIGINT, signal_handle);
+    signal(SIGTERM, signal_handle);
+
+    // initialize library without event thread, everything below runs in this thread
+    success = candle_initialize_ex(CANDLE_EVENT_MODE_APPLICATION);
+    if (!success) {
+        printf("initialize failure\n");
+        return -1;
+    }
+
+    // list device
+    struct candle_device **device_list;
+    size_t device_list_size = 0;
+    success = candle_get_device_list(&device_list, &device_list_size);
+    if (!success)
+        goto handle_error;
+    if (device_list_size == 0) {
+        candle_free_device_list(device_list);
+        printf("no device available\n");
+        goto finalize;
+    }
+
+    // using first device
+    struct candle_device *dev = device_list[0];
+    candle_ref_device(dev);
+
+    // free device list
+    candle_free_device_list(device_list);
+
+    // open device
+    success = candle_open_device(dev);
+    if (!success)
+        goto handle_error;
+
+    // start channel 0
+    success = candle_start_channel(dev, 0, CANDLE_MODE_LISTEN_ONLY | CANDLE_MODE_LOOP_BACK);
+    if (!success)
+        goto handle_error;
+
+    // the usb fds of the open device
+    struct candle_pollfd cfds[MAX_POLLFDS];
+    struct pollfd fds[MAX_POLLFDS];
+    size_t nfds;
+    success = candle_get_pollfds(cfds, MAX_POLLFDS, &nfds);
+    if (!success)
+        goto handle_error;
+    for (size_t i = 0; i < nfds; ++i) {
+        fds[i].fd = cfds[i].fd;
+        fds[i].events = cfds[i].events;
+    }
+
+    // one cycle: send, wait for usb events, handle them, drain the queue
+    struct candle_can_frame frame = {.type = 0, .can_id = 123, .can_dlc = 8, .data = {1, 2, 3, 4, 5, 6, 7, 8}};
+    struct candle_can_frame rx_frame;
+    uint64_t cycles = 0;
+    uint64_t received = 0;
+    while (!interrupt && cycles < 10000) {
+        uint64_t cycle_end = candle_monotonic_ns() + CYCLE_US * 1000ull;
+
+        if (!candle_send_frame_nowait(dev, 0, &frame))
+            printf("send failure in cycle %llu\n", (unsigned long long)cycles);
+
+        // poll until the end of the cycle, completions run inside candle_handle_events
+        uint64_t now;
+        while ((now = candle_monotonic_ns()) < cycle_end) {
+            int timeout_ms = (int)((cycle_end - now + 999999) / 1000000);
+            if (poll(fds, nfds, timeout_ms) > 0)
+                candle_handle_events(0);
+        }
+
+        while (candle_receive_frame_nowait(dev, 0, &rx_frame)) {
+            if (rx_frame.type & CANDLE_FRAME_TYPE_RX)
+                received++;
+        }
+        cycles++;
+    }
+    printf("%llu cycles, %llu frames received\n", (unsigned long long)cycles, (unsigned long long)received);
+
+    // close device
+    candle_close_device(dev);
+    candle_unref_device(dev);
+
+    goto finalize;
+
+handle_error:
+    printf("error occur\n");
+
+finalize:
+    // finalize library
+    candle_finalize();
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "cyclic.h"
+#include "clock.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
+
+
+#define MESSAGE_COUNT 40
+#define RUN_SECONDS 5
+#define ONE_SHOT_COUNT 2000
+#define ONE_SHOT_GAP_US 1500
+
+
+static const uint32_t periods_ms[] = {1, 2, 5, 10, 20, 50, 100};
+
+
+struct message {
+    uint32_t period_ms;
+    atomic_bool *stop;
+    struct candle_cyclic_stats stats;
+};
+
+
+static uint32_t period_of(int i) {
+    return periods_ms[i % (sizeof(periods_ms) / sizeof(periods_ms[0]))];
+}
+
+
+// stands in for candle_send_frame_nowait
+static bool dummy_send(void *context, uint8_t channel, struct candle_can_frame *frame, uint64_t deadline_ns) {
+    atomic_fetch_add((atomic_uint *)context, 1);
+    return true;
+}
+
+
+struct lateness {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+};
+
+
+// records how late each one-shot frame is submitted
+static bool lateness_send(void *context, uint8_t channel, struct candle_can_frame *frame, uint64_t deadline_ns) {
+    struct lateness *l = context;
+    uint64_t lateness = clock_monotonic_ns() - deadline_ns;
+    l->count++;
+    l->sum_ns += lateness;
+    if (lateness > l->max_ns)
+        l->max_ns = lateness;
+    return true;
+}
+
+
+static void run_one_shot(uint32_t spin_us) {
+    struct lateness l = {0};
+    struct candle_can_frame frame = {.can_id = 0x200, .can_dlc = 8};
+    cyclic_t *cyclic = cyclic_create(lateness_send, &l);
+
+    // a replay: frames at fixed future times, queued up front
+    cyclic_set_spin(cyclic, (uint64_t)spin_us * 1000u);
+    uint64_t start = clock_monotonic_ns() + 10000000u;
+    for (int i = 0; i < ONE_SHOT_COUNT; ++i)
+        cyclic_add_once(cyclic, 0, &frame, start + (uint64_t)i * ONE_SHOT_GAP_US * 1000u);
+
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = 100000000};
+    uint64_t end = start + (uint64_t)ONE_SHOT_COUNT * ONE_SHOT_GAP_US * 1000u;
+    while (clock_monotonic_ns() < end)
+        thrd_sleep(&ts, NULL);
+    thrd_sleep(&ts, NULL);
+    cyclic_destroy(cyclic);
+
+    printf("one-shot spin %3u us: %llu frames, mean lateness %.1f us, max lateness %.1f us\n", spin_us,
+           (unsigned long long)l.count, l.count ? (double)l.sum_ns / l.count / 1e3 : 0, l.max_ns / 1e3);
+}
+
+
+// what an application does without the scheduler: one thread per message sleeping for the period
+static int sleeper_thread_func(void *arg) {
+    struct message *m = arg;
+    struct timespec period = {.tv_sec = m->period_ms / 1000, .tv_nsec = (long)(m->period_ms % 1000) * 1000000};
+    uint64_t deadline = clock_monotonic_ns();
+
+    memset(&m->stats, 0, sizeof(m->stats));
+    while (!atomic_load(m->stop)) {
+        // lateness against the ideal schedule, every cycle adds its own wake-up delay
+        uint64_t lateness = clock_monotonic_ns() - deadline;
+        if (m->stats.sent == 0 || lateness < m->stats.jitter_min_ns)
+            m->stats.jitter_min_ns = lateness;
+        if (lateness > m->stats.jitter_max_ns)
+            m->stats.jitter_max_ns = lateness;
+        m->stats.jitter_sum_ns += lateness;
+        m->stats.sent++;
+
+        deadline += (uint64_t)m->period_ms * 1000000u;
+        thrd_sleep(&period, NULL);
+    }
+    return 0;
+}
+
+
+static void report(const char *name, struct candle_cyclic_stats *stats) {
+    uint64_t cycles = 0, sum = 0, max = 0, missed = 0;
+    for (int i = 0; i < MESSAGE_COUNT; ++i) {
+        cycles += stats[i].sent + stats[i].send_errors;
+        sum += stats[i].jitter_sum_ns;
+        missed += stats[i].missed;
+        if (stats[i].jitter_max_ns > max)
+            max = stats[i].jitter_max_ns;
+    }
+    printf("%-9s: %llu cycles, mean lateness %.1f us, max lateness %.1f us, %llu missed\n", name,
+           (unsigned long long)cycles, cycles ? (double)sum / cycles / 1e3 : 0, max / 1e3, (unsigned long long)missed);
+}
+
+
+int main(int argc, char *argv[]) {
+    struct timespec run = {.tv_sec = RUN_SECONDS, .tv_nsec = 0};
+    struct candle_cyclic_stats stats[MESSAGE_COUNT];
+
+    // one thread per message
+    thrd_t threads[MESSAGE_COUNT];
+    struct message messages[MESSAGE_COUNT];
+    atomic_bool stop;
+    atomic_init(&stop, false);
+    for (int i = 0; i < MESSAGE_COUNT; ++i) {
+        messages[i].period_ms = period_of(i);
+        messages[i].stop = &stop;
+        thrd_create(&threads[i], sleeper_thread_func, &messages[i]);
+    }
+    thrd_sleep(&run, NULL);
+    atomic_store(&stop, true);
+    for (int i = 0; i < MESSAGE_COUNT; ++i) {
+        thrd_join(threads[i], NULL);
+        stats[i] = messages[i].stats;
+    }
+    report("threads", stats);
+
+    // one scheduler thread
+    atomic_uint sent;
+    atomic_init(&sent, 0);
+    cyclic_t *cyclic = cyclic_create(dummy_send, &sent);
+    struct candle_can_frame frame = {.can_id = 0x100, .can_dlc = 8};
+    uint32_t ids[MESSAGE_COUNT];
+    for (int i = 0; i < MESSAGE_COUNT; ++i) {
+        frame.can_id = 0x100 + i;
+        cyclic_add(cyclic, 0, &frame, (uint64_t)period_of(i) * 1000000u, &ids[i]);
+    }
+    thrd_sleep(&run, NULL);
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+        cyclic_get_stats(cyclic, ids[i], &stats[i]);
+    cyclic_destroy(cyclic);
+    report("scheduler", stats);
+
+    // frames at absolute times (candle_send_frame_at), sleeping only and with a busy-wait
+    run_one_shot(0);
+    run_one_shot(100);
+
+    return 0;
+}
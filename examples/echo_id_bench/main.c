@@ -0,0 +1,115 @@
+#include "id_pool.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <threads.h>
+
+
+#define OPERATION_COUNT 2000000     // acquire/release pairs per thread
+#define HELD_IDS 3                  // ids every sender keeps in flight, 8 threads take 24 of 32
+#define MAX_THREADS 8
+
+
+struct bench {
+    const char *name;
+    int (*acquire)(id_pool_t *pool);
+    id_pool_t pool;
+    atomic_bool start;
+    atomic_uint_fast64_t failures;
+};
+
+
+// what candle_send_frame_nowait did before: blind fetch_or, then a linear scan for a free bit
+static int legacy_acquire(id_pool_t *pool) {
+    uint32_t echo_id_pool;
+    int echo_id = 0;
+    while (true) {
+        echo_id_pool = atomic_fetch_or(pool, 1u << echo_id);
+        if (!(echo_id_pool & (1u << echo_id)))
+            return echo_id;
+        if (echo_id_pool == (uint32_t)(-1))
+            return -1;
+        for (int i = 0; i < 32; ++i) {
+            if (!(echo_id_pool & (1u << i))) {
+                echo_id = i;
+                break;
+            }
+        }
+    }
+}
+
+
+static double elapsed(const struct timespec *st) {
+    struct timespec et;
+    timespec_get(&et, TIME_UTC);
+    return (double)(et.tv_sec - st->tv_sec) + (double)(et.tv_nsec - st->tv_nsec) / 1e9;
+}
+
+
+static int sender_thread_func(void *arg) {
+    struct bench *b = arg;
+    int held[HELD_IDS];
+    uint64_t failures = 0;
+
+    while (!atomic_load(&b->start))
+        thrd_yield();
+
+    // ring of in-flight ids, the oldest is echoed back when a new one is taken
+    for (int i = 0; i < HELD_IDS; ++i)
+        held[i] = -1;
+    for (uint32_t i = 0; i < OPERATION_COUNT; ++i) {
+        int slot = (int)(i % HELD_IDS);
+        if (held[slot] >= 0)
+            id_pool_release(&b->pool, held[slot]);
+        held[slot] = b->acquire(&b->pool);
+        if (held[slot] < 0)
+            failures++;
+    }
+    for (int i = 0; i < HELD_IDS; ++i) {
+        if (held[i] >= 0)
+            id_pool_release(&b->pool, held[i]);
+    }
+
+    atomic_fetch_add(&b->failures, failures);
+    return 0;
+}
+
+
+static void run(struct bench *b, int thread_count) {
+    thrd_t threads[MAX_THREADS];
+    struct timespec st;
+
+    atomic_init(&b->pool, 0);
+    atomic_init(&b->start, false);
+    atomic_init(&b->failures, 0);
+
+    for (int i = 0; i < thread_count; ++i)
+        thrd_create(&threads[i], sender_thread_func, b);
+
+    timespec_get(&st, TIME_UTC);
+    atomic_store(&b->start, true);
+    for (int i = 0; i < thread_count; ++i)
+        thrd_join(threads[i], NULL);
+    double dt = elapsed(&st);
+
+    uint64_t operations = (uint64_t)OPERATION_COUNT * thread_count;
+    printf("%-7s %d threads: %.1f ns/acquire, %.2f M acquires/s, %llu failed%s\n", b->name, thread_count,
+           dt * 1e9 / operations, operations / dt / 1e6, (unsigned long long)atomic_load(&b->failures),
+           atomic_load(&b->pool) == 0 ? "" : " (LEAK)");
+}
+
+
+int main(int argc, char *argv[]) {
+    struct bench benches[] = {
+        {.name = "legacy", .acquire = legacy_acquire},
+        {.name = "bitscan", .acquire = id_pool_acquire}
+    };
+
+    // several sender threads sharing the echo ids of one channel
+    for (int thread_count = 1; thread_count <= MAX_THREADS; thread_count *= 2) {
+        for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); ++i)
+            run(&benches[i], thread_count);
+    }
+
+    return 0;
+}
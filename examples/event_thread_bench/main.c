@@ -0,0 +1,162 @@
+#include "candle_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+
+#define FRAME_COUNT 20000   // per device
+
+
+struct device_bench {
+    struct candle_device *dev;
+    atomic_uint completed;
+    atomic_uint_fast64_t latency_sum_ns;
+    atomic_uint_fast64_t latency_max_ns;
+    bool failed;
+};
+
+
+// runs on the event thread serving the device
+static void tx_complete(struct candle_device *device, uint8_t channel, const struct candle_tx_completion *completion, void *user) {
+    struct device_bench *b = user;
+    uint64_t max = atomic_load(&b->latency_max_ns);
+    while (completion->latency_ns > max && !atomic_compare_exchange_weak(&b->latency_max_ns, &max, completion->latency_ns));
+    atomic_fetch_add(&b->latency_sum_ns, completion->latency_ns);
+    atomic_fetch_add(&b->completed, 1);
+}
+
+
+static bool start_device(struct device_bench *b, const struct candle_event_thread_config *config) {
+    atomic_init(&b->completed, 0);
+    atomic_init(&b->latency_sum_ns, 0);
+    atomic_init(&b->latency_max_ns, 0);
+    b->failed = false;
+
+    struct candle_bit_timing bt = {.prop_seg = 1, .phase_seg1 = 43, .phase_seg2 = 15, .sjw = 15, .brp = 2};
+    return candle_set_event_thread(b->dev, config) && candle_open_device(b->dev) &&
+           candle_set_bit_timing(b->dev, 0, &bt) && candle_set_tx_callback(b->dev, 0, tx_complete, b) &&
+           candle_start_channel(b->dev, 0, CANDLE_MODE_LOOP_BACK);
+}
+
+
+// one sender per device, echoes are drained from the rx queue as they come
+static int sender_thread_func(void *arg) {
+    struct device_bench *b = arg;
+    struct candle_can_frame frame = {.type = 0, .can_id = 0x123, .can_dlc = 8};
+    struct candle_can_frame rx;
+
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
+        frame.tag = i;
+        memcpy(frame.data, &i, sizeof(i));
+        if (!candle_send_frame(b->dev, 0, &frame, 1000)) {
+            b->failed = true;
+            break;
+        }
+        while (candle_receive_frame_nowait(b->dev, 0, &rx));
+    }
+
+    // wait for the last echoes
+    for (int i = 0; i < 100 && atomic_load(&b->completed) < FRAME_COUNT; ++i) {
+        thrd_sleep(&(struct timespec){.tv_nsec = 10000000}, NULL);
+        while (candle_receive_frame_nowait(b->dev, 0, &rx));
+    }
+    return 0;
+}
+
+
+static void run(const char *name, struct device_bench *benches, size_t count, enum candle_event_thread_policy policy, int cpu_base, int priority) {
+    for (size_t i = 0; i < count; ++i) {
+        // sharded: two devices per thread
+        struct candle_event_thread_config config = {
+            .policy = policy,
+            .shard = (uint32_t)(i / 2),
+            .cpu = cpu_base < 0 ? -1 : cpu_base + (int)(policy == CANDLE_EVENT_THREAD_SHARDED ? i / 2 : i),
+            .priority = priority
+        };
+        if (!start_device(&benches[i], &config)) {
+            printf("%s: cannot start device %zu (affinity or priority refused?)\n", name, i);
+            for (size_t j = 0; j <= i; ++j)
+                candle_close_device(benches[j].dev);
+            return;
+        }
+    }
+
+    thrd_t *threads = calloc(count, sizeof(thrd_t));
+    uint64_t st = candle_monotonic_ns();
+    for (size_t i = 0; i < count; ++i)
+        thrd_create(&threads[i], sender_thread_func, &benches[i]);
+    for (size_t i = 0; i < count; ++i)
+        thrd_join(threads[i], NULL);
+    double dt = (double)(candle_monotonic_ns() - st) / 1e9;
+    free(threads);
+
+    uint64_t completed = 0, latency_sum = 0, latency_max = 0;
+    for (size_t i = 0; i < count; ++i) {
+        completed += atomic_load(&benches[i].completed);
+        latency_sum += atomic_load(&benches[i].latency_sum_ns);
+        if (atomic_load(&benches[i].latency_max_ns) > latency_max)
+            latency_max = atomic_load(&benches[i].latency_max_ns);
+        if (benches[i].failed)
+            printf("%s: device %zu send failure\n", name, i);
+        candle_close_device(benches[i].dev);
+    }
+
+    printf("%-10s %zu devices: %.0f frames/s, echo latency mean %.1f us, max %.1f us\n", name, count,
+           (double)completed / dt, completed ? (double)latency_sum / (double)completed / 1e3 : 0, (double)latency_max / 1e3);
+}
+
+
+int main(int argc, char *argv[]) {
+    // usage: event_thread_bench [first cpu] [SCHED_FIFO priority]
+    int cpu_base = argc > 1 ? atoi(argv[1]) : -1;
+    int priority = argc > 2 ? atoi(argv[2]) : 0;
+
+    // initialize library
+    if (!candle_initialize()) {
+        printf("initialize failure\n");
+        return -1;
+    }
+
+    // list device
+    struct candle_device **device_list;
+    size_t device_list_size = 0;
+    if (!candle_get_device_list(&device_list, &device_list_size)) {
+        printf("error occur\n");
+        candle_finalize();
+        return -1;
+    }
+    if (device_list_size == 0) {
+        candle_free_device_list(device_list);
+        printf("no device available\n");
+        candle_finalize();
+        return 0;
+    }
+
+    struct device_bench *benches = calloc(device_list_size, sizeof(struct device_bench));
+    for (size_t i = 0; i < device_list_size; ++i)
+        benches[i].dev = candle_ref_device(device_list[i]);
+    candle_free_device_list(device_list);
+
+    // 1, 2, 4, ... devices running at once under each policy
+    for (size_t count = 1; ; count *= 2) {
+        if (count > device_list_size)
+            count = device_list_size;
+
+        run("shared", benches, count, CANDLE_EVENT_THREAD_SHARED, cpu_base, priority);
+        run("sharded", benches, count, CANDLE_EVENT_THREAD_SHARDED, cpu_base, priority);
+        run("per-device", benches, count, CANDLE_EVENT_THREAD_PER_DEVICE, cpu_base, priority);
+
+        if (count == device_list_size)
+            break;
+    }
+
+    for (size_t i = 0; i < device_list_size; ++i)
+        candle_unref_device(benches[i].dev);
+    free(benches);
+
+    // finalize library
+    candle_finalize();
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "candle_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+
+#define PING_ID 0x100
+#define PONG_ID 0x101
+
+
+// With two devices on one bus the second answers every ping like examples/ping_pong does,
+// with a single device in loopback the looped back ping is the pong.
+struct bench {
+    struct candle_device *pinger;
+    struct candle_device *ponger;   // NULL in loopback
+    atomic_bool run;
+};
+
+
+static int ponger_thread_func(void *arg) {
+    struct bench *b = arg;
+    struct candle_can_frame frame;
+
+    while (atomic_load(&b->run)) {
+        if (!candle_receive_frame(b->ponger, 0, &frame, 100))
+            continue;
+        if (!(frame.type & CANDLE_FRAME_TYPE_RX) || frame.can_id != PING_ID)
+            continue;
+
+        frame.type = 0;
+        frame.can_id = PONG_ID;
+        candle_send_frame_nowait(b->ponger, 0, &frame);
+    }
+    return 0;
+}
+
+
+static bool start_device(struct candle_device *dev, uint32_t busy_poll_us, enum candle_mode mode) {
+    struct candle_event_thread_config config = {.policy = CANDLE_EVENT_THREAD_SHARED, .shard = 0, .cpu = -1, .priority = 0, .busy_poll_us = busy_poll_us};
+    struct candle_bit_timing bt = {.prop_seg = 1, .phase_seg1 = 43, .phase_seg2 = 15, .sjw = 15, .brp = 2};
+    return candle_set_event_thread(dev, &config) && candle_open_device(dev) &&
+           candle_set_busy_poll(dev, busy_poll_us) && candle_set_bit_timing(dev, 0, &bt) &&
+           candle_start_channel(dev, 0, mode);
+}
+
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+
+static void run(struct bench *b, const char *name, uint32_t busy_poll_us, uint64_t *rtt, size_t rounds) {
+    bool loopback = b->ponger == NULL;
+    if (!start_device(b->pinger, busy_poll_us, loopback ? CANDLE_MODE_LOOP_BACK : CANDLE_MODE_NORMAL) ||
+        (!loopback && !start_device(b->ponger, busy_poll_us, CANDLE_MODE_NORMAL))) {
+        printf("%s: cannot start devices\n", name);
+        candle_close_device(b->pinger);
+        if (!loopback)
+            candle_close_device(b->ponger);
+        return;
+    }
+
+    thrd_t ponger;
+    atomic_store(&b->run, true);
+    if (!loopback)
+        thrd_create(&ponger, ponger_thread_func, b);
+
+    // one frame in flight, the round trip ends when the pinger's receive call returns
+    struct candle_can_frame ping = {.type = 0, .can_id = PING_ID, .can_dlc = 8};
+    struct candle_can_frame frame;
+    size_t done = 0;
+    size_t lost = 0;
+    for (size_t i = 0; i < rounds; ++i) {
+        ping.data[0] = (uint8_t)i;
+        uint64_t start = candle_monotonic_ns();
+        if (!candle_send_frame_nowait(b->pinger, 0, &ping)) {
+            lost++;
+            continue;
+        }
+
+        bool received = false;
+        while (!received && candle_receive_frame(b->pinger, 0, &frame, 100)) {
+            if (loopback)
+                received = frame.can_id == PING_ID && frame.data[0] == (uint8_t)i;
+            else
+                received = (frame.type & CANDLE_FRAME_TYPE_RX) && frame.can_id == PONG_ID && frame.data[0] == (uint8_t)i;
+        }
+        if (received)
+            rtt[done++] = candle_monotonic_ns() - start;
+        else
+            lost++;
+    }
+
+    atomic_store(&b->run, false);
+    if (!loopback)
+        thrd_join(ponger, NULL);
+    candle_close_device(b->pinger);
+    if (!loopback)
+        candle_close_device(b->ponger);
+
+    if (done == 0) {
+        printf("%-10s no round trip completed\n", name);
+        return;
+    }
+    qsort(rtt, done, sizeof(uint64_t), compare_u64);
+    printf("%-10s %8zu rounds %6zu lost  p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us  max %8.1f us\n", name, done, lost,
+           (double)rtt[done / 2] / 1000.0, (double)rtt[done * 99 / 100] / 1000.0,
+           (double)rtt[done * 999 / 1000] / 1000.0, (double)rtt[done - 1] / 1000.0);
+}
+
+
+int main(int argc, char *argv[]) {
+    // usage: ping_pong_latency [rounds] [busy poll us]
+    size_t rounds = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+    uint32_t busy_poll_us = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 50;
+    if (rounds == 0)
+        return -1;
+
+    // initialize library
+    if (!candle_initialize()) {
+        printf("initialize failure\n");
+        return -1;
+    }
+
+    // list device
+    struct candle_device **device_list;
+    size_t device_list_size = 0;
+    if (!candle_get_device_list(&device_list, &device_list_size)) {
+        printf("error occur\n");
+        candle_finalize();
+        return -1;
+    }
+    if (device_list_size == 0) {
+        candle_free_device_list(device_list);
+        printf("no device available\n");
+        candle_finalize();
+        return 0;
+    }
+
+    struct bench b;
+    b.pinger = candle_ref_device(device_list[0]);
+    b.ponger = device_list_size > 1 ? candle_ref_device(device_list[1]) : NULL;
+    atomic_init(&b.run, false);
+    candle_free_device_list(device_list);
+    printf("%s, %zu rounds\n", b.ponger != NULL ? "device 0 pings device 1" : "device 0 in loopback", rounds);
+
+    uint64_t *rtt = malloc(rounds * sizeof(uint64_t));
+    if (rtt != NULL) {
+        run(&b, "sleep", 0, rtt, rounds);
+        run(&b, "busy poll", busy_poll_us, rtt, rounds);
+        free(rtt);
+    }
+
+    candle_unref_device(b.pinger);
+    if (b.ponger != NULL)
+        candle_unref_device(b.ponger);
+
+    // finalize library
+    candle_finalize();
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "candle_api.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <poll.h>
+
+
+static bool interrupt;
+
+
+void signal_handle(int signal) {
+    interrupt = true;
+}
+
+
+static bool start_device(struct candle_device *dev) {
+    if (!candle_open_device(dev))
+        return false;
+
+    for (uint8_t ch = 0; ch < dev->channel_count; ++ch) {
+        struct candle_bit_timing bt = {.prop_seg = 1, .phase_seg1 = 43, .phase_seg2 = 15, .sjw = 15, .brp = 2};
+        if (!candle_set_bit_timing(dev, ch, &bt))
+            return false;
+
+        if (!candle_start_channel(dev, ch, CANDLE_MODE_NORMAL))
+            return false;
+    }
+
+    return true;
+}
+
+
+int main(int argc, char *argv[]) {
+    bool success;
+
+    // catch signal to exit
+    signal(SIGINT, signal_handle);
+    signal(SIGTERM, signal_handle);
+
+    // initialize library
+    success = candle_initialize();
+    if (!success) {
+        printf("initialize failure\n");
+        return -1;
+    }
+
+    // list device
+    struct candle_device **device_list;
+    size_t device_list_size = 0;
+    success = candle_get_device_list(&device_list, &device_list_size);
+    if (!success)
+        goto handle_error;
+    if (device_list_size == 0) {
+        candle_free_device_list(device_list);
+        printf("no device available\n");
+        goto finalize;
+    }
+
+    // open every device and collect their event fds
+    struct candle_device **devs = calloc(device_list_size, sizeof(struct candle_device *));
+    struct pollfd *fds = calloc(device_list_size, sizeof(struct pollfd));
+    if (devs == NULL || fds == NULL) {
+        candle_free_device_list(device_list);
+        goto handle_error;
+    }
+    for (size_t i = 0; i < device_list_size; ++i) {
+        devs[i] = candle_ref_device(device_list[i]);
+        fds[i].events = POLLIN;
+        if (!start_device(devs[i]) || !candle_get_event_fd(devs[i], &fds[i].fd)) {
+            printf("cannot start device %zu\n", i);
+            fds[i].fd = -1;     // ignored by poll
+        }
+    }
+    candle_free_device_list(device_list);
+
+    // a single thread serves all devices
+    struct candle_can_frame frame;
+    while (!interrupt) {
+        if (poll(fds, device_list_size, 1000) <= 0)
+            continue;
+
+        for (size_t i = 0; i < device_list_size; ++i) {
+            if (!(fds[i].revents & POLLIN))
+                continue;
+
+            // reset first, a frame queued while draining makes the fd readable again
+            candle_reset_event_fd(devs[i]);
+            for (uint8_t ch = 0; ch < devs[i]->channel_count; ++ch) {
+                while (candle_receive_frame_nowait(devs[i], ch, &frame)) {
+                    if (frame.type & CANDLE_FRAME_TYPE_RX)
+                        printf("device %zu channel %u, id: 0x%X, dlc: %u\n", i, ch, frame.can_id, frame.can_dlc);
+                }
+            }
+        }
+    }
+
+    // close devices
+    for (size_t i = 0; i < device_list_size; ++i) {
+        candle_close_device(devs[i]);
+        candle_unref_device(devs[i]);
+    }
+    free(devs);
+    free(fds);
+
+    goto finalize;
+
+handle_error:
+    printf("error occur\n");
+
+finalize:
+    // finalize library
+    candle_finalize();
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "fifo.h"
+#include "spsc.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <threads.h>
+
+
+#define ELEMENT_SIZE 80     // largest gs_host_frame (canfd_ts)
+#define QUEUE_DEPTH 1024
+#define ELEMENT_COUNT 10000000
+
+
+struct queue_ops {
+    const char *name;
+    void *queue;
+    int (*put)(void *queue, void *element);
+    int (*get)(void *queue, void *element);
+};
+
+
+static int fifo_put_op(void *queue, void *element) {
+    return fifo_put(queue, element);
+}
+
+static int fifo_get_op(void *queue, void *element) {
+    return fifo_get(queue, element);
+}
+
+static int spsc_put_op(void *queue, void *element) {
+    return spsc_put(queue, element);
+}
+
+static int spsc_get_op(void *queue, void *element) {
+    return spsc_get(queue, element);
+}
+
+
+static double elapsed(const struct timespec *st) {
+    struct timespec et;
+    timespec_get(&et, TIME_UTC);
+    return (double)(et.tv_sec - st->tv_sec) + (double)(et.tv_nsec - st->tv_nsec) / 1e9;
+}
+
+
+static int producer_thread_func(void *arg) {
+    struct queue_ops *ops = arg;
+    uint8_t element[ELEMENT_SIZE];
+
+    memset(element, 0, sizeof(element));
+    for (uint32_t i = 0; i < ELEMENT_COUNT; ++i) {
+        memcpy(element, &i, sizeof(i));
+        while (ops->put(ops->queue, element) != 0)
+            thrd_yield();
+    }
+
+    return 0;
+}
+
+
+static bool run(struct queue_ops *ops) {
+    thrd_t producer_thread;
+    uint8_t element[ELEMENT_SIZE];
+    struct timespec st;
+    bool in_order = true;
+
+    timespec_get(&st, TIME_UTC);
+    thrd_create(&producer_thread, producer_thread_func, ops);
+
+    for (uint32_t i = 0; i < ELEMENT_COUNT; ++i) {
+        while (ops->get(ops->queue, element) != 0)
+            thrd_yield();
+
+        uint32_t n;
+        memcpy(&n, element, sizeof(n));
+        if (n != i)
+            in_order = false;
+    }
+
+    thrd_join(producer_thread, NULL);
+    double dt = elapsed(&st);
+
+    printf("%-6s: %d frames in %.3f s, %.2f M frames/s, %.1f ns/frame%s\n", ops->name, ELEMENT_COUNT, dt,
+           ELEMENT_COUNT / dt / 1e6, dt * 1e9 / ELEMENT_COUNT, in_order ? "" : " (ORDER ERROR)");
+    return in_order;
+}
+
+
+int main(int argc, char *argv[]) {
+    fifo_t *fifo = fifo_create(ELEMENT_SIZE, QUEUE_DEPTH);
+    spsc_t *spsc = spsc_create(ELEMENT_SIZE, QUEUE_DEPTH);
+    if (fifo == NULL || spsc == NULL) {
+        printf("cannot create queue\n");
+        return -1;
+    }
+
+    struct queue_ops ops[] = {
+        {.name = "fifo", .queue = fifo, .put = fifo_put_op, .get = fifo_get_op},
+        {.name = "spsc", .queue = spsc, .put = spsc_put_op, .get = spsc_get_op}
+    };
+
+    // one producer thread (libusb event thread) and one consumer thread (reader)
+    bool success = true;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i)
+        success &= run(&ops[i]);
+
+    fifo_destroy(fifo);
+    spsc_destroy(spsc);
+    return success ? 0 : -1;
+}
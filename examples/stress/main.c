@@ -4,6 +4,7 @@
 #include <threads.h>
 
 
+static const size_t rx_transfer_depths[] = {1, 2, 4, 8, 16, 32};
 static thrd_t receive_thread;
 static bool interrupt;
 
@@ -17,11 +18,19 @@ struct test_epoch {
 };
 
 
+static double elapsed(const struct timespec *st) {
+    struct timespec et;
+    timespec_get(&et, TIME_UTC);
+    return (double)(et.tv_sec - st->tv_sec) + (double)(et.tv_nsec - st->tv_nsec) / 1e9;
+}
+
+
 static int receive_thread_func(void *arg) {
     struct test_epoch *e = arg;
 
     struct candle_can_frame frame;
-    time_t st = time(NULL);
+    struct timespec st;
+    timespec_get(&st, TIME_UTC);
     while (!interrupt) {
         if (!candle_receive_frame(e->dev, 0, &frame, 1000))
             continue;
@@ -35,7 +44,7 @@ static int receive_thread_func(void *arg) {
                 e->tx_cnt++;
         }
     }
-    e->dt = difftime(time(NULL), st);
+    e->dt = elapsed(&st);
 
     while (candle_receive_frame(e->dev, 0, &frame, 1000));
 
@@ -72,20 +81,26 @@ int main(int argc, char *argv[]) {
     // free device list
     candle_free_device_list(device_list);
 
-    // open device
-    success = candle_open_device(dev);
-    if (!success)
-        goto handle_error;
+    // start stress test (one epoch per rx transfer depth)
+    struct test_epoch e;
+    double fps[sizeof(rx_transfer_depths) / sizeof(rx_transfer_depths[0])] = {0};
+    for (size_t i = 0; i < sizeof(rx_transfer_depths) / sizeof(rx_transfer_depths[0]) && dev->is_connected; ++i) {
+        printf("Test epoch %d (rx transfer depth: %d)\n", (int)i + 1, (int)rx_transfer_depths[i]);
 
-    // start channel 0 in loop back mode
-    success = candle_start_channel(dev, 0, CANDLE_MODE_LISTEN_ONLY | CANDLE_MODE_LOOP_BACK);
-    if (!success)
-        goto handle_error;
+        // set rx transfer depth (device must be closed)
+        success = candle_set_rx_transfer_count(dev, rx_transfer_depths[i]);
+        if (!success)
+            goto handle_error;
 
-    // start stress test
-    struct test_epoch e;
-    for (int i = 0; i < 3 && dev->is_connected; ++i) {
-        printf("Test epoch %d\n", i + 1);
+        // open device
+        success = candle_open_device(dev);
+        if (!success)
+            goto handle_error;
+
+        // start channel 0 in loop back mode
+        success = candle_start_channel(dev, 0, CANDLE_MODE_LISTEN_ONLY | CANDLE_MODE_LOOP_BACK);
+        if (!success)
+            goto handle_error;
 
         // reset epoch
         e.tx_cnt = 0;
@@ -109,12 +124,23 @@ int main(int argc, char *argv[]) {
         // join thread
         thrd_join(receive_thread, NULL);
 
+        // read channel statistics
+        struct candle_channel_stats stats;
+        candle_get_channel_stats(dev, 0, &stats);
+
+        // close device
+        candle_close_device(dev);
+
         // calculate result
-        printf("tx: %d, rx %d, err: %d, dt: %d s\n", e.tx_cnt, e.rx_cnt, e.err_cnt, (int)e.dt);
+        fps[i] = (e.tx_cnt + e.rx_cnt) / e.dt;
+        printf("tx: %d, rx %d, err: %d, dt: %.3f s, %.0f frames/s, tx pool exhausted: %d\n", e.tx_cnt, e.rx_cnt, e.err_cnt, e.dt, fps[i], (int)stats.tx_pool_exhausted);
     }
 
-    // close device
-    candle_close_device(dev);
+    // summary
+    printf("\nrx transfer depth | frames/s\n");
+    for (size_t i = 0; i < sizeof(rx_transfer_depths) / sizeof(rx_transfer_depths[0]); ++i)
+        printf("%17d | %.0f\n", (int)rx_transfer_depths[i], fps[i]);
+
     candle_unref_device(dev);
 
     goto finalize;
@@ -0,0 +1,127 @@
+#include "candle_api.h"
+#include <stdio.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+
+#define FRAME_COUNT 1000
+
+
+static bool interrupt;
+static atomic_uint completed;
+static atomic_uint_fast64_t latency_sum_ns;
+static atomic_uint_fast64_t latency_max_ns;
+
+
+void signal_handle(int signal) {
+    interrupt = true;
+}
+
+
+// runs on the event thread once the frame is on the bus
+static void tx_complete(struct candle_device *device, uint8_t channel, const struct candle_tx_completion *completion, void *user) {
+    uint64_t max = atomic_load(&latency_max_ns);
+    while (completion->latency_ns > max && !atomic_compare_exchange_weak(&latency_max_ns, &max, completion->latency_ns));
+    atomic_fetch_add(&latency_sum_ns, completion->latency_ns);
+
+    if (completion->tag % 100 == 0)
+        printf("frame %llu on the bus after %.1f us (hardware timestamp %llu us)\n", (unsigned long long)completion->tag,
+               completion->latency_ns / 1e3, (unsigned long long)completion->timestamp_us);
+    atomic_fetch_add(&completed, 1);
+}
+
+
+int main(int argc, char *argv[]) {
+    bool success;
+
+    // catch signal to exit
+    signal(SIGINT, signal_handle);
+    signal(SIGTERM, signal_handle);
+
+    // initialize library
+    success = candle_initialize();
+    if (!success) {
+        printf("initialize failure\n");
+        return -1;
+    }
+
+    // list device
+    struct candle_device **device_list;
+    size_t device_list_size = 0;
+    success = candle_get_device_list(&device_list, &device_list_size);
+    if (!success)
+        goto handle_error;
+    if (device_list_size == 0) {
+        candle_free_device_list(device_list);
+        printf("no device available\n");
+        goto finalize;
+    }
+
+    // using first device
+    struct candle_device *dev = device_list[0];
+    candle_ref_device(dev);
+
+    // free device list
+    candle_free_device_list(device_list);
+
+    // open device
+    success = candle_open_device(dev);
+    if (!success)
+        goto handle_error;
+
+    // set bit timing
+    struct candle_bit_timing bt = {.prop_seg = 1, .phase_seg1 = 43, .phase_seg2 = 15, .sjw = 15, .brp = 2};
+    success = candle_set_bit_timing(dev, 0, &bt);
+    if (!success)
+        goto handle_error;
+
+    // report every echo, must be set while the channel is stopped
+    success = candle_set_tx_callback(dev, 0, tx_complete, NULL);
+    if (!success)
+        goto handle_error;
+
+    // start channel 0 in loop back mode, no other node is needed
+    enum candle_mode mode = CANDLE_MODE_LOOP_BACK;
+    if (dev->channels[0].feature & CANDLE_FEATURE_HW_TIMESTAMP)
+        mode |= CANDLE_MODE_HW_TIMESTAMP;
+    success = candle_start_channel(dev, 0, mode);
+    if (!success)
+        goto handle_error;
+
+    // send tagged frames
+    struct candle_can_frame frame = {.type = 0, .can_id = 0x123, .can_dlc = 8};
+    for (uint64_t i = 0; i < FRAME_COUNT && !interrupt; ++i) {
+        frame.tag = i;
+        frame.data[0] = (uint8_t)i;
+        if (!candle_send_frame(dev, 0, &frame, 1000))
+            goto handle_error;
+
+        // drain the queue, echoes are queued as well
+        struct candle_can_frame rx;
+        while (candle_receive_frame_nowait(dev, 0, &rx));
+    }
+
+    // wait for the last echoes
+    for (int i = 0; i < 100 && atomic_load(&completed) < FRAME_COUNT; ++i)
+        thrd_sleep(&(struct timespec){.tv_nsec = 10000000}, NULL);
+
+    unsigned int count = atomic_load(&completed);
+    if (count != 0)
+        printf("%u frames completed, average latency %.1f us, max %.1f us\n", count,
+               atomic_load(&latency_sum_ns) / 1e3 / count, atomic_load(&latency_max_ns) / 1e3);
+
+    // close device
+    candle_close_device(dev);
+    candle_unref_device(dev);
+
+    goto finalize;
+
+handle_error:
+    printf("error occur\n");
+
+finalize:
+    // finalize library
+    candle_finalize();
+    return 0;
+}
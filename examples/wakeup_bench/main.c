@@ -0,0 +1,147 @@
+#include "spsc.h"
+#include "wakeup.h"
+#include "clock.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <threads.h>
+
+
+#define ELEMENT_SIZE 80     // largest gs_host_frame (canfd_ts)
+#define QUEUE_DEPTH 1024
+#define ELEMENT_COUNT 400000
+#define BURST_SIZE 16       // frames completed back to back before the bus goes quiet
+#define BURST_GAP_US 50
+
+
+struct bench {
+    const char *name;
+    bool always_signal;
+    bool polling_reader;    // reader spins on the queue and never waits
+    spsc_t *ring;
+    wakeup_t channel_rx;    // reader blocks here
+    wakeup_t device_rx;     // nobody waits (like candle_wait_for_frame unused)
+    wakeup_t echo_id;       // nobody waits (tx window not full)
+    atomic_bool done;
+    double cpu;
+    uint32_t dropped;
+};
+
+
+static double thread_cpu_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+// what receive_bulk_callback did before: lock, signal and unlock each condition variable
+static void notify_always(wakeup_t *w) {
+    mono_cond_lock(&w->cond);
+    mono_cond_signal(&w->cond);
+    mono_cond_unlock(&w->cond);
+}
+
+
+static int event_thread_func(void *arg) {
+    struct bench *b = arg;
+    uint8_t element[ELEMENT_SIZE];
+
+    memset(element, 0, sizeof(element));
+    b->cpu = 0;
+    double st = 0;
+    for (uint32_t i = 0; i < ELEMENT_COUNT; ++i) {
+        // quiet bus between bursts lets the reader block, only the bursts are timed
+        if (i % BURST_SIZE == 0) {
+            if (i != 0)
+                b->cpu += thread_cpu_time() - st;
+            struct timespec gap = {.tv_sec = 0, .tv_nsec = BURST_GAP_US * 1000};
+            thrd_sleep(&gap, NULL);
+            st = thread_cpu_time();
+        }
+
+        memcpy(element, &i, sizeof(i));
+        if (spsc_put(b->ring, element) != 0) {
+            b->dropped++;
+            continue;
+        }
+
+        if (b->always_signal) {
+            notify_always(&b->echo_id);
+            notify_always(&b->channel_rx);
+            notify_always(&b->device_rx);
+        } else {
+            wakeup_signal(&b->echo_id);
+            wakeup_signal(&b->channel_rx);
+            wakeup_signal(&b->device_rx);
+        }
+    }
+    b->cpu += thread_cpu_time() - st;
+
+    atomic_store(&b->done, true);
+    wakeup_broadcast(&b->channel_rx);
+    return 0;
+}
+
+
+static void run(struct bench *b) {
+    thrd_t event_thread;
+    uint8_t element[ELEMENT_SIZE];
+    uint32_t received = 0;
+
+    b->ring = spsc_create(ELEMENT_SIZE, QUEUE_DEPTH);
+    wakeup_init(&b->channel_rx);
+    wakeup_init(&b->device_rx);
+    wakeup_init(&b->echo_id);
+    atomic_init(&b->done, false);
+    b->dropped = 0;
+
+    thrd_create(&event_thread, event_thread_func, b);
+
+    // reader loop of candle_receive_frame
+    while (true) {
+        if (spsc_get(b->ring, element) == 0) {
+            received++;
+            continue;
+        }
+        if (atomic_load(&b->done) && spsc_is_empty(b->ring))
+            break;
+        if (b->polling_reader) {
+            thrd_yield();
+            continue;
+        }
+
+        wakeup_lock(&b->channel_rx);
+        if (spsc_is_empty(b->ring) && !atomic_load(&b->done))
+            wakeup_wait_until(&b->channel_rx, clock_monotonic_ns() + 1000000000u);
+        wakeup_unlock(&b->channel_rx);
+    }
+
+    thrd_join(event_thread, NULL);
+
+    printf("%-16s: %u frames received, %u dropped, event thread %.3f s cpu, %.1f ns/frame\n", b->name, received,
+           b->dropped, b->cpu, b->cpu * 1e9 / ELEMENT_COUNT);
+
+    wakeup_destroy(&b->channel_rx);
+    wakeup_destroy(&b->device_rx);
+    wakeup_destroy(&b->echo_id);
+    spsc_destroy(b->ring);
+}
+
+
+int main(int argc, char *argv[]) {
+    struct bench benches[] = {
+        {.name = "always/blocking", .always_signal = true, .polling_reader = false},
+        {.name = "waiters/blocking", .always_signal = false, .polling_reader = false},
+        {.name = "always/polling", .always_signal = true, .polling_reader = true},
+        {.name = "waiters/polling", .always_signal = false, .polling_reader = true}
+    };
+
+    // one event thread (producer) and one reader
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); ++i)
+        run(&benches[i]);
+
+    return 0;
+}